@@ -76,15 +76,17 @@ struct channel {
 	struct disk devices[2];     /* The devices on this channel. */
 };
 
-/* We support the two "legacy" ATA channels found in a standard PC. */
-#define CHANNEL_CNT 2
+/* We support the two "legacy" ATA channels found in a standard PC,
+   plus the tertiary and quaternary ISA channels, which the pintos
+   utility adds only to attach extra swap disks. */
+#define CHANNEL_CNT 4
 static struct channel channels[CHANNEL_CNT];
 
 static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t sec_cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -116,6 +118,14 @@ disk_init (void) {
 				c->reg_base = 0x170;
 				c->irq = 15 + 0x20;
 				break;
+			case 2:
+				c->reg_base = 0x1e8;
+				c->irq = 11 + 0x20;
+				break;
+			case 3:
+				c->reg_base = 0x168;
+				c->irq = 10 + 0x20;
+				break;
 			default:
 				NOT_REACHED ();
 		}
@@ -136,6 +146,11 @@ disk_init (void) {
 			d->read_cnt = d->write_cnt = 0;
 		}
 
+		/* A floating bus reads as all ones: there is no controller
+		   here, so leave both devices absent. */
+		if (chan_no >= 2 && inb (reg_status (c)) == 0xff)
+			continue;
+
 		/* Register interrupt handler. */
 		intr_register_ext (c->irq, interrupt_handler, c->name);
 
@@ -181,6 +196,7 @@ disk_print_stats (void) {
 0:1 - file system
 1:0 - scratch
 1:1 - swap
+2:0, 2:1, 3:0, 3:1 - extra swap, if attached
 */
 struct disk *
 disk_get (int chan_no, int dev_no) {
@@ -209,47 +225,105 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
+	disk_read_multiple (d, sec_no, buffer, 1);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, buffer, 1);
+}
+
+/* Reads SEC_CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for SEC_CNT * DISK_SECTOR_SIZE
+   bytes, using as few ATA commands as possible. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t sec_cnt) {
+	disk_read_scatter (d, sec_no, &buffer, 1, sec_cnt);
+}
+
+/* Writes SEC_CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, using as few ATA commands as possible. */
+void
+disk_write_multiple (struct disk *d, disk_sector_t sec_no, const void *buffer,
+		size_t sec_cnt) {
+	disk_write_gather (d, sec_no, &buffer, 1, sec_cnt);
+}
+
+/* Reads BUF_CNT * BUF_SECS consecutive sectors starting at SEC_NO
+   from disk D.  The first BUF_SECS sectors go to BUFS[0], the next
+   BUF_SECS to BUFS[1], and so on, so that e.g. a run of swap slots
+   can be read into unrelated frames.  A single READ SECTOR command
+   transfers up to DISK_MAX_XFER sectors. */
+void
+disk_read_scatter (struct disk *d, disk_sector_t sec_no, void *const bufs[],
+		size_t buf_cnt, size_t buf_secs) {
 	struct channel *c;
+	size_t total = buf_cnt * buf_secs;
+	size_t i;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (bufs != NULL);
+	ASSERT (buf_secs > 0);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
+	for (i = 0; i < total; i++) {
+		if (i % DISK_MAX_XFER == 0) {
+			size_t cnt = total - i < DISK_MAX_XFER ? total - i : DISK_MAX_XFER;
+			select_sector (d, sec_no + i, cnt);
+			issue_pio_command (c, CMD_READ_SECTOR_RETRY);
+		}
+		/* The device interrupts once per sector of the command. */
+		sema_down (&c->completion_wait);
+		if (!wait_while_busy (d))
+			PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name,
+					(disk_sector_t) (sec_no + i));
+		input_sector (c, (uint8_t *) bufs[i / buf_secs]
+				+ (i % buf_secs) * DISK_SECTOR_SIZE);
+		d->read_cnt++;
+	}
 	lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
-   Internally synchronizes accesses to disks, so external
-   per-disk locking is unneeded. */
+/* Writes BUF_CNT * BUF_SECS consecutive sectors starting at SEC_NO
+   to disk D, taking BUF_SECS sectors from each of BUFS in turn.
+   Returns after the disk has acknowledged receiving the data. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+disk_write_gather (struct disk *d, disk_sector_t sec_no,
+		const void *const bufs[], size_t buf_cnt, size_t buf_secs) {
 	struct channel *c;
+	size_t total = buf_cnt * buf_secs;
+	size_t i;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (bufs != NULL);
+	ASSERT (buf_secs > 0);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	for (i = 0; i < total; i++) {
+		if (i % DISK_MAX_XFER == 0) {
+			size_t cnt = total - i < DISK_MAX_XFER ? total - i : DISK_MAX_XFER;
+			select_sector (d, sec_no + i, cnt);
+			issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
+		}
+		if (!wait_while_busy (d))
+			PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name,
+					(disk_sector_t) (sec_no + i));
+		output_sector (c, (const uint8_t *) bufs[i / buf_secs]
+				+ (i % buf_secs) * DISK_SECTOR_SIZE);
+		sema_down (&c->completion_wait);
+		d->write_cnt++;
+	}
 	lock_release (&c->lock);
 }
-
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -402,17 +476,18 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and SEC_CNT to the disk's sector selection
+   registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t sec_cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (sec_cnt > 0 && sec_cnt <= DISK_MAX_XFER);
+	ASSERT (sec_no + sec_cnt <= d->capacity);
+	ASSERT (sec_no + sec_cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), sec_cnt == DISK_MAX_XFER ? 0 : sec_cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
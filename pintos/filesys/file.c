@@ -98,6 +98,15 @@ off_t file_write_at(struct file *file, const void *buffer, off_t size, off_t fil
   return inode_write_at(file->inode, buffer, size, file_ofs);
 }
 
+/* Writes SIZE bytes into FILE from offset FILE_OFS on, taking them a page
+ * at a time from the CNT pages PAGES, with as few disk commands as
+ * possible. Returns the number of bytes actually written.
+ * The file's current position is unaffected. */
+off_t file_write_pages_at(struct file *file, const void *const pages[], size_t cnt, off_t size,
+                          off_t file_ofs) {
+  return inode_write_pages_at(file->inode, pages, cnt, size, file_ofs);
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void file_deny_write(struct file *file) {
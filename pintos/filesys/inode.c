@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/vaddr.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -287,6 +288,73 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	return bytes_written;
 }
 
+/* Returns true if the page's worth of INODE's bytes at sector-aligned
+ * POS lies in the consecutive sectors starting at SEC. */
+static bool
+page_at_sectors (const struct inode *inode, off_t pos, disk_sector_t sec) {
+	for (size_t i = 0; i < PGSIZE / DISK_SECTOR_SIZE; i++)
+		if (byte_to_sector (inode, pos + i * DISK_SECTOR_SIZE) != sec + i)
+			return false;
+	return true;
+}
+
+/* Writes SIZE bytes into INODE starting at OFFSET, taking them a page
+ * at a time from the CNT pages PAGES; only the last page may be used
+ * partly.  When OFFSET is sector-aligned, each run of whole pages that
+ * byte_to_sector() maps to consecutive sectors goes to disk with as few
+ * disk commands as possible rather than one per sector.  Returns the
+ * number of bytes actually written, like inode_write_at(). */
+off_t
+inode_write_pages_at (struct inode *inode, const void *const pages[],
+		size_t cnt, off_t size, off_t offset) {
+	off_t written = 0;
+	size_t full;
+
+	ASSERT (size <= (off_t) (cnt * PGSIZE));
+
+	if (inode->deny_write_cnt || offset >= inode_length (inode))
+		return 0;
+	if (size > inode_length (inode) - offset)
+		size = inode_length (inode) - offset;
+
+	full = offset % DISK_SECTOR_SIZE == 0 ? size / PGSIZE : 0;
+	for (size_t i = 0; i < full; ) {
+		disk_sector_t sec = byte_to_sector (inode, offset + written);
+		size_t run = 0;
+
+		while (i + run < full
+				&& page_at_sectors (inode, offset + written + run * PGSIZE,
+					sec + run * (PGSIZE / DISK_SECTOR_SIZE)))
+			run++;
+		if (run == 0) {
+			/* The page's sectors are scattered. */
+			off_t n = inode_write_at (inode, pages[i], PGSIZE, offset + written);
+
+			written += n;
+			if (n != PGSIZE)
+				return written;
+			i++;
+			continue;
+		}
+		disk_write_gather (filesys_disk, sec, pages + i, run,
+				PGSIZE / DISK_SECTOR_SIZE);
+		written += run * PGSIZE;
+		i += run;
+	}
+
+	/* The partial last page, or every page if the sectors do not line
+	   up with them. */
+	for (size_t i = full; i < cnt && written < size; i++) {
+		off_t chunk = size - written < PGSIZE ? size - written : PGSIZE;
+		off_t n = inode_write_at (inode, pages[i], chunk, offset + written);
+
+		written += n;
+		if (n != chunk)
+			break;
+	}
+	return written;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 	void
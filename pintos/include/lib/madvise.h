@@ -0,0 +1,13 @@
+#ifndef __LIB_MADVISE_H
+#define __LIB_MADVISE_H
+
+/* Advice for the madvise system call. */
+#define MADV_NORMAL 0           /* No particular order of access. */
+#define MADV_RANDOM 1           /* Random access: read no neighbours. */
+#define MADV_SEQUENTIAL 2       /* Sequential access: read far ahead,
+                                   and drop pages behind. */
+#define MADV_WILLNEED 3         /* The range will be used soon. */
+#define MADV_DONTNEED 4         /* The range is not needed anymore:
+                                   its contents may be discarded. */
+
+#endif /* lib/madvise.h */
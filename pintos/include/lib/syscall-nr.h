@@ -36,6 +36,12 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_MSYNC,                  /* Write a mapping back to its file. */
+	SYS_VMSTAT,                 /* Get virtual memory counters. */
+	SYS_MADVISE,                /* Give advice about the use of memory. */
+	SYS_RSSLIMIT,               /* Limit the frames a process maps. */
 };
 
 #endif /* lib/syscall-nr.h */
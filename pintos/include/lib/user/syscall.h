@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <madvise.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -41,6 +43,10 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int msync (void *addr, size_t length);
+int vmstat (struct vmstat *stat, bool system);
+int madvise (void *addr, size_t length, int advice);
+int rsslimit (size_t pages);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -0,0 +1,55 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+#include <stdint.h>
+
+/* Buckets of the fault latency histogram.  Bucket 0 counts the
+   faults served in fewer than VMSTAT_LAT_BASE CPU cycles, bucket
+   I > 0 those served in fewer than VMSTAT_LAT_BASE << I cycles
+   but not faster, and the last bucket every slower fault. */
+#define VMSTAT_LAT_BUCKETS 16
+#define VMSTAT_LAT_BASE 1024
+
+/* Virtual memory counters, kept for each process and for the
+   whole system.  Returned by the vmstat system call. */
+struct vmstat {
+	uint64_t minor_faults;      /* Faults served without I/O. */
+	uint64_t major_faults;      /* Faults that read from swap or a file. */
+	uint64_t stack_faults;      /* Faults that grew the stack. */
+	uint64_t swap_ins;          /* Anonymous pages read back from swap. */
+	uint64_t swap_outs;         /* Anonymous pages written to swap. */
+	uint64_t file_reads;        /* Faults that read a file. */
+	uint64_t evictions_anon;    /* Anonymous pages evicted. */
+	uint64_t evictions_file;    /* Pages of mmaps evicted. */
+	uint64_t evictions_text;    /* Pages of executables evicted. */
+	uint64_t writebacks;        /* Dirty mmap pages written to their files. */
+	uint64_t clock_sweeps;      /* Frames looked at by the replacement
+	                               policy, system-wide only. */
+	uint64_t fault_latency[VMSTAT_LAT_BUCKETS];
+	uint64_t rss;               /* Frames mapped now. */
+	uint64_t rss_peak;          /* Most frames mapped at once. */
+	uint64_t rss_limit;         /* Resident set limit, 0 if none.
+	                               Per process only. */
+	uint64_t kswapd_wakeups;    /* Times the page-out daemon was woken. */
+	uint64_t kswapd_reclaimed;  /* Frames it freed. */
+	uint64_t direct_reclaims;   /* Faults that found no free frame and
+	                               evicted.  System-wide only, like the
+	                               two above. */
+	uint64_t huge_pages;        /* Huge pages mapped. */
+	uint64_t huge_splits;       /* ...broken up into pages again. */
+	uint64_t prezeroed;         /* Frames zeroed ahead of use,
+	                               system-wide only. */
+	uint64_t zero_hits;         /* Zero-fill faults that took one of them. */
+	uint64_t zero_misses;       /* ...that found none and zeroed a frame. */
+	uint64_t batched_unmaps;    /* Pages unmapped with their TLB flush
+	                               put off, system-wide only. */
+	uint64_t tlb_flushes;       /* ...batches flushed by reloading CR3. */
+	uint64_t teardowns;         /* Address spaces torn down. */
+	uint64_t teardown_pages;    /* ...pages they had. */
+	uint64_t teardown_cycles;   /* ...time it took, in TSC cycles. */
+	uint64_t rss_reclaims;      /* Faults served by evicting a page of the
+	                               same process, at its resident set
+	                               limit. */
+};
+
+#endif /* lib/vmstat.h */
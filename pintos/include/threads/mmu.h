@@ -2,11 +2,24 @@
 #define THREAD_MMU_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "threads/pte.h"
 
 typedef bool pte_for_each_func (uint64_t *pte, void *va, void *aux);
 
+/* Pages whose TLB entries invalidate one at a time; a batch of more
+   is flushed by reloading CR3. */
+#define TLB_BATCH_MAX 32
+
+/* TLB invalidations put off by pml4_clear_page_batched() until
+   tlb_batch_flush(). */
+struct tlb_batch {
+	uint64_t *pml4;                 /* Page map the pages were cleared in. */
+	size_t cnt;                     /* Pages cleared since the last flush. */
+	void *pages[TLB_BATCH_MAX];     /* The first TLB_BATCH_MAX of them. */
+};
+
 uint64_t *pml4e_walk (uint64_t *pml4, const uint64_t va, int create);
 uint64_t *pml4_create (void);
 bool pml4_for_each (uint64_t *, pte_for_each_func *, void *);
@@ -15,8 +28,17 @@ void pml4_activate (uint64_t *pml4);
 void *pml4_get_page (uint64_t *pml4, const void *upage);
 bool pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
 void pml4_clear_page (uint64_t *pml4, void *upage);
+void pml4_restore_page (uint64_t *pml4, void *upage, void *kpage);
+void tlb_batch_init (struct tlb_batch *, uint64_t *pml4);
+void pml4_clear_page_batched (struct tlb_batch *, void *upage);
+void tlb_batch_flush (struct tlb_batch *);
+bool pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_is_huge (uint64_t *pml4, const void *upage);
+bool pml4_split_huge (uint64_t *pml4, const void *upage);
 bool pml4_is_dirty (uint64_t *pml4, const void *upage);
 void pml4_set_dirty (uint64_t *pml4, const void *upage, bool dirty);
+bool pml4_is_writable (uint64_t *pml4, const void *upage);
+void pml4_set_writable (uint64_t *pml4, const void *upage, bool writable);
 bool pml4_is_accessed (uint64_t *pml4, const void *upage);
 void pml4_set_accessed (uint64_t *pml4, const void *upage, bool accessed);
 
@@ -10,12 +10,4 @@ int process_wait(tid_t);
 void process_exit(void);
 void process_activate(struct thread *next);
 
-struct load_aux {
-  struct file *file;
-  off_t seg_ofs;
-
-  size_t read_bytes;
-  size_t zero_bytes;
-};
-
 #endif /* userprog/process.h */
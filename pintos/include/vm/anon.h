@@ -1,16 +1,37 @@
 #ifndef VM_ANON_H
 #define VM_ANON_H
 // #include "vm/vm.h"
+#include <stddef.h>
+#include <stdint.h>
+
 #include "vm/vm_types.h"
 
 // struct page;
 // enum vm_type;
+struct frame;
 
 struct anon_page {
   size_t slot;
+  bool cached; /* The frame being filled holds the contents of SLOT already. */
+};
+
+/* Swap slots are handed out in clusters of SWAP_CLUSTER consecutive slots,
+ * each for one aligned run of as many virtual pages. */
+#define SWAP_CLUSTER 16
+#define SWAP_CLUSTER_CACHE 4
+
+/* The cluster of a run of pages of a process. */
+struct swap_cluster {
+  uintptr_t run;  /* Virtual page number / SWAP_CLUSTER. */
+  size_t base;    /* First slot. */
 };
 
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+void anon_dup_slot(struct page *dst, struct page *src);
+void anon_release_slots(struct page *pages[], size_t cnt);
+struct frame *swap_readahead(struct page *page);
+void swap_print_stats(void);
+bool swap_parse_devices(char *spec);
 
 #endif
@@ -1,17 +1,59 @@
 #ifndef VM_FILE_H
 #define VM_FILE_H
 #include "filesys/file.h"
+#include "threads/synch.h"
 #include "vm/vm_types.h"
 // #include "vm/vm.h"
 
 // struct page;
 // enum vm_type;
 struct thread;
+struct frame;
 
 struct file_page {
   struct file *file;
   off_t ofs;
   size_t read_bytes;
+  bool text; /* Allocated as VM_TEXT. */
+};
+
+/* -readahead=PAGES: Largest read-ahead window of an mmap. */
+#define RA_MAX 32
+extern size_t readahead_max;
+
+/* A window being read ahead by the read-ahead thread. */
+struct mmap_ra_window {
+  struct list_elem elem;       /* Element of the read-ahead queue. */
+  struct file *file;
+  size_t first, step, cnt;     /* Page indexes FIRST + i * STEP, for i < CNT. */
+  off_t ofs[RA_MAX];           /* File offset and bytes of each page. */
+  size_t bytes[RA_MAX];
+  struct frame *frames[RA_MAX]; /* Filled frames, NULL where none was free. */
+};
+
+/* A page read ahead and not faulted on yet. */
+struct mmap_ra_page {
+  struct list_elem elem; /* Element of the cached read-ahead list while FRAME is set. */
+  size_t idx;          /* Page index in the mapping. */
+  struct frame *frame; /* Pinned and without pages, NULL if the slot is free. */
+};
+
+/* Read-ahead state of an mmap. Only the mapping process touches it, except
+ * for CACHE, whose frames reclaim may take under ra_lock, WINDOW, which
+ * belongs to the read-ahead thread while BUSY, and DONE, which that thread
+ * ups when it is finished with WINDOW. */
+struct mmap_ra {
+  size_t prev;   /* Page index of the last fault, or SIZE_MAX. */
+  size_t stride; /* Distance between the last two faults. */
+  size_t step;   /* Distance between pages of the stream, 0 if there is none. */
+  size_t size;   /* Pages in the latest window. */
+  size_t marker; /* First page of the latest window. */
+  size_t next;   /* Page after the latest window. */
+  struct mmap_ra_page cache[2 * RA_MAX];
+  size_t hand;   /* Next cache slot to reuse when all are taken. */
+  bool busy;
+  struct semaphore done; /* Upped when WINDOW has been read. */
+  struct mmap_ra_window window;
 };
 
 struct mmap_desc {
@@ -20,23 +62,38 @@ struct mmap_desc {
   struct file *file;
   off_t ofs;
   bool writable;
+  struct vma *vma; /* Region of the mapping. */
   struct list_elem elem;
+  struct mmap_ra ra;
 };
 
+/* Aux of a page loaded lazily from a file: an mmap page or a page of an
+ * executable's segment. Every uninit page with an initializer has one.
+ * The rest of the page after READ_BYTES is zeroed. */
 struct file_load_aux {
   struct file *file;
   off_t file_ofs;
-  size_t read_bytes;
-  size_t zero_bytes;
-  struct list_elem elem;
-  void *va;
+  uint32_t read_bytes;
+  const void *prefetch; /* READ_BYTES of contents already read ahead, or NULL */
 };
 
+bool file_load_contents(struct file_load_aux *aux, void *kva);
+bool lazy_load_file(struct page *page, void *aux);
+void file_backed_bind(struct page *page);
+
 void vm_file_init(void);
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset);
 void do_munmap(struct mmap_desc *desc);
 struct mmap_desc *mmap_lookup(struct thread *t, void *addr);
+struct frame *mmap_readahead(struct page *page, bool *stream);
+void mmap_readahead_stop(struct thread *t);
+struct frame *mmap_ra_reclaim(void);
+void mmap_writeback_all(void);
+void mmap_writeback_range(void *start, void *end);
+void mmap_willneed(struct mmap_desc *desc, void *start, void *end);
+bool do_msync(void *addr, size_t length);
+void vm_file_print_stats(void);
 bool set_dirty_to_file(uint64_t *pml4, struct page *p);
 
 #endif
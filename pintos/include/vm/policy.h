@@ -0,0 +1,56 @@
+#ifndef VM_POLICY_H
+#define VM_POLICY_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct frame;
+
+/* Refault distance of a page that was never evicted. */
+#define VM_NO_REFAULT SIZE_MAX
+
+/* A page-replacement policy. Every hook is called with the frame table
+ * lock held. */
+struct vm_policy {
+  const char *name;
+
+  /* Sets up the policy for the CNT frames of TABLE. */
+  void (*init)(struct frame *table, size_t cnt);
+  /* FRAME has just been filled. DIST is the number of evictions since its
+   * page was last evicted, or VM_NO_REFAULT. */
+  void (*insert)(struct frame *frame, size_t dist);
+  /* FRAME was referenced in a way the accessed bits do not show. */
+  void (*access)(struct frame *frame);
+  /* Returns an evictable frame, or NULL if none can be found now. */
+  struct frame *(*victim)(void);
+  /* FRAME no longer holds a page. May be called for frames that were
+   * never inserted. */
+  void (*remove)(struct frame *frame);
+};
+
+/* The policy in use. */
+extern const struct vm_policy *vm_policy;
+
+extern const struct vm_policy vm_policy_clock;
+extern const struct vm_policy vm_policy_2q;
+extern const struct vm_policy vm_policy_clockpro;
+
+/* Counters shown by vm_policy_print_stats(). */
+struct vm_policy_stats {
+  long long faults;    /* Frames filled on a fault. */
+  long long refaults;  /* ...for pages that had been evicted before. */
+  long long evictions; /* Pages evicted. */
+  long long hits;      /* References to resident frames seen by the policy. */
+  long long local;     /* Evictions taken from processes over their target. */
+  long long around;    /* Pages mapped ahead of use by fault-around. */
+  long long text;      /* Text pages mapped from another process's frame. */
+};
+extern struct vm_policy_stats vm_policy_stats;
+
+bool vm_policy_select(const char *name);
+void vm_policy_print_stats(void);
+
+/* For the policies, implemented in vm.c. */
+bool vm_frame_evictable(const struct frame *frame);
+bool vm_frame_referenced(struct frame *frame);
+
+#endif
@@ -1,12 +1,14 @@
 #ifndef VM_VM_H
 #define VM_VM_H
 #include <stdbool.h>
+#include <vmstat.h>
 
 #include "hash.h"
 #include "threads/palloc.h"
 #include "vm/anon.h"
 #include "vm/file.h"
 #include "vm/uninit.h"
+#include "vm/vma.h"
 #include "vm/vm_types.h"
 
 #ifdef EFILESYS
@@ -29,8 +31,10 @@ struct page {
 
   /* Your implementation */
   struct hash_elem hash_elem;
+  struct supplemental_page_table *spt; /* Owner, see page_pml4() */
+  struct page *next_sharer; /* Next page sharing the same frame (copy-on-write) */
+  uint32_t evict_stamp;     /* vm eviction count when last evicted, 0 if never */
   bool writable;
-  uint64_t *pml4;
 
   /* Per-type data are binded into the union.
    * Each function automatically detects the current union */
@@ -44,13 +48,18 @@ struct page {
   };
 };
 
-/* The representation of "frame" */
+/* The representation of "frame".
+ * There is one frame per page of the user pool, kept in an array indexed
+ * by page number, so a frame is free when it has no PAGE and is not pinned.
+ * A frame may be mapped by several pages at once after fork (copy-on-write).
+ * PAGE is the first of them and the rest are chained through
+ * page->next_sharer; REF_CNT is the length of that chain. */
 struct frame {
   void *kva;
   struct page *page;
+  uint32_t ref_cnt;
   bool pinned;
-  struct list_elem elem;
-  // uint64_t owners_pml4;
+  bool zeroed; /* Holds only zeros, while it has no pages. */
 };
 
 /* The function table for page operations.
@@ -73,7 +82,30 @@ struct page_operations {
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
 struct supplemental_page_table {
-  struct hash hash_table;
+  struct hash hash_table; /* Pages created so far. */
+  struct vma *vmas;       /* Regions whose pages are created on first use. */
+
+  /* Working set, controlled by page-fault frequency. Protected by the
+   * frame table lock. */
+  size_t resident;      /* Frames mapped by this process. */
+  size_t target;        /* Frames it keeps when others are over their target. */
+  bool over;            /* RESIDENT > TARGET. */
+  size_t wss;           /* Working set size at the last sample. */
+  int64_t window_start; /* Tick the current fault window started. */
+  size_t window_refaults; /* Refaults during the current window. */
+
+  struct vmstat stat;     /* Counters of this process, see vm_stat_inc(). */
+
+  /* Resident set limit: most frames the process maps, 0 if unlimited.
+   * Kept across exec and inherited on fork. */
+  size_t rss_limit;
+  size_t rss_peak;        /* Highest RESIDENT so far. */
+
+  /* Clusters of the runs of pages swapped out last, the first
+   * SWAP_CLUSTER_CNT of them in use. Protected by the swap lock. */
+  struct swap_cluster swap_clusters[SWAP_CLUSTER_CACHE];
+  size_t swap_cluster_cnt;
+  size_t swap_cluster_hand;
 };
 
 #include "threads/thread.h"
@@ -82,10 +114,25 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst,
                                   struct supplemental_page_table *src);
 void supplemental_page_table_kill(struct supplemental_page_table *spt);
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va);
+struct page *spt_lookup_page(struct supplemental_page_table *spt, void *va);
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
+void spt_remove_range(struct supplemental_page_table *spt, void *start, void *end);
+
+/* Returns the page map of the process owning PAGE. Every table is part of
+ * its process's thread, so pages need not keep a pointer to the map. */
+#define page_pml4(page) \
+  (((struct thread *)((uint8_t *)(page)->spt - offsetof(struct thread, spt)))->pml4)
+
+/* Counters of the whole system. */
+extern struct vmstat vm_stat;
+
+/* Counts an event of the process owning SPT in MEMBER of its counters
+ * and of the system's. */
+#define vm_stat_inc(spt, member) ((spt)->stat.member++, vm_stat.member++)
 
 void vm_init(void);
+void vm_print_stats(void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write, bool not_present);
 
 #define vm_alloc_page(type, upage, writable) \
@@ -93,9 +140,36 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writable,
                                     vm_initializer *init, void *aux);
 void vm_dealloc_page(struct page *page);
+struct frame *vm_alloc_frame(void);
+void vm_free_frame(struct frame *frame);
+struct frame *vm_pin_page(struct page *page);
+void vm_unpin_frame(struct frame *frame);
+bool vm_pin_buffer(const void *buffer, size_t length, bool write);
+void vm_get_stat(struct vmstat *stat, bool system);
+void vm_set_rss_limit(size_t limit);
+void vm_unpin_buffer(const void *buffer, size_t length);
+size_t vm_pin_dirty_file_pages(struct page *pages[], size_t max);
 bool vm_claim_page(void *va);
 enum vm_type page_get_type(struct page *page);
 
 bool valid_stack_growth(void *va, struct intr_frame *f, bool user);
+bool do_madvise(void *addr, size_t length, int advice);
+
+/* -faultaround=PAGES: Pages a fault on a file-backed page maps at once. */
+#define FAULT_AROUND_MAX 32
+extern size_t fault_around_pages;
+
+/* -watermarks=LOW,HIGH: Free frames at which the page-out daemon starts and
+ * stops reclaiming. */
+extern size_t vm_low_watermark, vm_high_watermark;
+
+/* -nohuge: Whether large zero-fill regions get huge pages. */
+extern bool vm_huge_pages;
+
+/* -prezero=PAGES: Frames kept zeroed ahead of use. */
+extern size_t zero_pool_max;
+
+/* -rsslimit=PAGES: Resident set limit of processes that set none. */
+extern size_t vm_rss_limit;
 
 #endif /* VM_VM_H */
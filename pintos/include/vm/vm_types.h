@@ -24,6 +24,10 @@ enum vm_type {
   VM_MARKER_0 = (1 << 3),
   VM_MARKER_1 = (1 << 4),
 
+  /* Read-only page of an executable. Processes mapping the same page of
+   * the same file share its frame. */
+  VM_TEXT = VM_MARKER_1,
+
   /* DO NOT EXCEED THIS VALUE. */
   VM_MARKER_END = (1 << 31),
 };
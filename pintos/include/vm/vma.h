@@ -0,0 +1,44 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "filesys/off_t.h"
+#include "vm/vm_types.h"
+
+struct file;
+struct mmap_desc;
+struct supplemental_page_table;
+
+/* A region of a process's address space: an mmap or a segment of its
+ * executable. The pages of a region are only created when first looked up,
+ * so setting one up costs the same however large it is. */
+struct vma {
+  uint8_t *start, *end; /* Page-aligned bounds, END excluded. */
+  enum vm_type type;    /* Type of the pages, with its markers. */
+  bool writable;
+  struct file *file;    /* The pages are read from FILE from OFS on... */
+  off_t ofs;
+  size_t read_bytes;    /* ...READ_BYTES in all, the rest is zeros. */
+  vm_initializer *init; /* Loads a page with file contents. */
+  bool zero_anon;       /* Pages with nothing to read are zero-fill anonymous pages. */
+  bool owns_file;       /* FILE is closed with the region. */
+  struct mmap_desc *mmap; /* The mmap this region is, or NULL. */
+  int advice;           /* MADV_* last given for the region by madvise(). */
+
+  struct vma *left, *right; /* AVL tree ordered by START. */
+  int height;
+};
+
+bool vma_insert(struct supplemental_page_table *spt, struct vma *vma);
+void vma_remove(struct supplemental_page_table *spt, struct vma *vma);
+struct vma *vma_find(struct supplemental_page_table *spt, const void *va);
+bool vma_overlaps(struct supplemental_page_table *spt, const void *start, const void *end);
+void vma_page_layout(const struct vma *vma, const void *va, off_t *ofs, size_t *read_bytes);
+void vma_destroy(struct vma *vma);
+bool vma_for_each(struct supplemental_page_table *spt, bool (*func)(struct vma *, void *aux),
+                  void *aux);
+void vma_kill_all(struct supplemental_page_table *spt);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Default size of the compressed pool, in pages of the kernel pool. */
+#define ZSWAP_DEFAULT_PAGES 64
+
+/* -zswap=PAGES: Size of the compressed pool. 0 disables it. */
+extern size_t zswap_budget;
+
+/* Writes the page at KVA to swap slot SLOT on disk. */
+typedef void zswap_writeback_func(size_t slot, const void *kva);
+
+void zswap_init(zswap_writeback_func *writeback);
+bool zswap_store(size_t slot, const void *kva);
+bool zswap_load(size_t slot, void *kva);
+void zswap_invalidate(size_t slot);
+void zswap_print_stats(void);
+
+#endif
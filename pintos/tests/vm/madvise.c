@@ -0,0 +1,45 @@
+/* Gives each kind of advice with madvise and checks that the
+   contents of the memory are as expected afterward: a mapping
+   keeps what was written to it through MADV_DONTNEED, while
+   anonymous memory reads as zeros again. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+static char zeros[4096];
+static char page[4096] __attribute__ ((aligned (4096)));
+
+void
+test_main (void)
+{
+  int handle;
+  void *map;
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED, "mmap \"sample.txt\"");
+
+  CHECK (madvise (map, 4096, MADV_SEQUENTIAL) == 0, "madvise sequential");
+  CHECK (madvise (map, 4096, MADV_RANDOM) == 0, "madvise random");
+  CHECK (madvise (map, 4096, MADV_WILLNEED) == 0, "madvise willneed");
+  memcpy (ACTUAL, sample, strlen (sample));
+  CHECK (madvise (map, 4096, MADV_DONTNEED) == 0, "madvise dontneed on mapping");
+  CHECK (!memcmp (ACTUAL, sample, strlen (sample)),
+         "mapping keeps written data");
+
+  memset (page, 0xcc, sizeof page);
+  CHECK (madvise (page, sizeof page, MADV_DONTNEED) == 0,
+         "madvise dontneed on anonymous page");
+  CHECK (!memcmp (page, zeros, sizeof page), "anonymous page reads as zeros");
+
+  CHECK (madvise (map, 4096, 42) == -1, "madvise bad advice");
+  CHECK (madvise ((char *) ACTUAL + 4096, 4096, MADV_NORMAL) == -1,
+         "madvise unmapped range");
+  munmap (map);
+  close (handle);
+}
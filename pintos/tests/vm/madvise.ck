@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise) begin
+(madvise) create "sample.txt"
+(madvise) open "sample.txt"
+(madvise) mmap "sample.txt"
+(madvise) madvise sequential
+(madvise) madvise random
+(madvise) madvise willneed
+(madvise) madvise dontneed on mapping
+(madvise) mapping keeps written data
+(madvise) madvise dontneed on anonymous page
+(madvise) anonymous page reads as zeros
+(madvise) madvise bad advice
+(madvise) madvise unmapped range
+(madvise) end
+EOF
+pass;
@@ -0,0 +1,23 @@
+/* Verifies that a mapping is disallowed when its first page is free
+   but a later one is in use by the stack, and that the stack page
+   survives the attempt. */
+
+#include <stdint.h>
+#include <round.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  volatile int canary = 0x5a5a5a5a;
+  uintptr_t handle_page = ROUND_DOWN ((uintptr_t) &handle, 4096);
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap ((void *) (handle_page - 4096), 8192, 0, handle, 0) == MAP_FAILED,
+         "try to mmap over the page below the stack and the stack");
+  munmap ((void *) (handle_page - 4096));
+  CHECK (canary == 0x5a5a5a5a, "stack page intact");
+}
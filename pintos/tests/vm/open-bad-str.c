@@ -0,0 +1,29 @@
+/* Passes open() a name that runs off the end of a mapping, in a child,
+   which must be killed without leaving the file system locked: the
+   parent can still open a file afterward. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char *name = (char *) 0x10000000;
+  int handle;
+  pid_t child;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (name, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  memset (name, 'x', 4096);
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      open (name);
+      fail ("open() of an unterminated name returned");
+    }
+  CHECK (wait (child) == -1, "wait for child");
+  CHECK (open ("sample.txt") > 1, "open \"sample.txt\" again");
+}
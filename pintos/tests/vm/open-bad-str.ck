@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(open-bad-str) begin
+(open-bad-str) open "sample.txt"
+(open-bad-str) mmap "sample.txt"
+child: exit(-1)
+(open-bad-str) wait for child
+(open-bad-str) open "sample.txt" again
+(open-bad-str) end
+open-bad-str: exit(0)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Limits this process to a few resident frames, then writes and
+   reads back many more pages than that.  The pages must keep
+   their contents while the resident set stays within the limit. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LIMIT 32
+#define PAGE_CNT 128
+
+static char buf[PAGE_CNT * 4096];
+
+void
+test_main (void)
+{
+  struct vmstat st;
+  size_t i;
+
+  CHECK (rsslimit (LIMIT) == 0, "rsslimit %d", LIMIT);
+  for (i = 0; i < PAGE_CNT; i++)
+    memset (buf + i * 4096, i + 1, 4096);
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * 4096] != (char) (i + 1) || buf[i * 4096 + 4095] != (char) (i + 1))
+      fail ("page %zu lost its contents", i);
+  msg ("pages keep their contents");
+
+  CHECK (vmstat (&st, false) == 0, "vmstat");
+  CHECK (st.rss_limit == LIMIT, "limit is reported");
+  CHECK (st.rss <= LIMIT, "resident set within the limit");
+  CHECK (st.rss_peak >= st.rss, "peak is at least the current size");
+  CHECK (rsslimit (0) == 0, "lift the limit");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(rsslimit) begin
+(rsslimit) rsslimit 32
+(rsslimit) pages keep their contents
+(rsslimit) vmstat
+(rsslimit) limit is reported
+(rsslimit) resident set within the limit
+(rsslimit) peak is at least the current size
+(rsslimit) lift the limit
+(rsslimit) end
+EOF
+pass;
@@ -0,0 +1,39 @@
+/* Touches a number of fresh pages and checks that the vmstat
+   system call counted a fault for each of them, both for this
+   process and for the whole system. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_CNT 16
+
+static char buf[PAGE_CNT * 4096];
+
+static uint64_t
+faults (const struct vmstat *st)
+{
+  return st->minor_faults + st->major_faults;
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, after, sys;
+  uint64_t histogram = 0;
+  size_t i;
+
+  CHECK (vmstat (&before, false) == 0, "vmstat");
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * 4096] = 1;
+  CHECK (vmstat (&after, false) == 0, "vmstat again");
+  CHECK (vmstat (&sys, true) == 0, "system-wide vmstat");
+
+  CHECK (faults (&after) - faults (&before) >= PAGE_CNT,
+         "counted a fault per page touched");
+  for (i = 0; i < VMSTAT_LAT_BUCKETS; i++)
+    histogram += after.fault_latency[i];
+  CHECK (histogram == faults (&after), "latency histogram covers every fault");
+  CHECK (faults (&sys) >= faults (&after), "system counts include this process");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat) begin
+(vmstat) vmstat
+(vmstat) vmstat again
+(vmstat) system-wide vmstat
+(vmstat) counted a fault per page touched
+(vmstat) latency histogram covers every fault
+(vmstat) system counts include this process
+(vmstat) end
+EOF
+pass;
@@ -30,7 +30,10 @@
 #endif
 #include "tests/threads/tests.h"
 #ifdef VM
+#include "vm/anon.h"
 #include "vm/vm.h"
+#include "vm/policy.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -226,6 +229,35 @@ parse_options (char **argv) {
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-zswap"))
+			zswap_budget = atoi (value);
+		else if (!strcmp (name, "-faultaround"))
+			fault_around_pages = atoi (value);
+		else if (!strcmp (name, "-readahead"))
+			readahead_max = atoi (value);
+		else if (!strcmp (name, "-watermarks")) {
+			char *high = strchr (value, ',');
+
+			vm_low_watermark = atoi (value);
+			if (high != NULL)
+				vm_high_watermark = atoi (high + 1);
+		}
+		else if (!strcmp (name, "-nohuge"))
+			vm_huge_pages = false;
+		else if (!strcmp (name, "-prezero"))
+			zero_pool_max = atoi (value);
+		else if (!strcmp (name, "-rsslimit"))
+			vm_rss_limit = atoi (value);
+		else if (!strcmp (name, "-swap")) {
+			if (value == NULL || !swap_parse_devices (value))
+				PANIC ("bad swap devices `%s'", value);
+		}
+		else if (!strcmp (name, "-vmpolicy")) {
+			if (value == NULL || !vm_policy_select (value))
+				PANIC ("unknown replacement policy `%s'", value);
+		}
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -328,6 +360,29 @@ usage (void) {
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -zswap=PAGES       Compress swapped pages into up to PAGES pages\n"
+			"                     of memory before writing them to disk.\n"
+			"  -faultaround=PAGES Map up to PAGES pages of a file per fault\n"
+			"                     (default 8, at most 32, 1 disables).\n"
+			"  -readahead=PAGES   Read up to PAGES pages of an mmap ahead of a\n"
+			"                     stream of faults (default 16, at most 32,\n"
+			"                     0 disables).\n"
+			"  -watermarks=LOW,HIGH Reclaim frames in the background from LOW\n"
+			"                     free frames until HIGH are free.\n"
+			"  -nohuge            Never map anonymous memory with huge pages.\n"
+			"  -prezero=PAGES     Keep up to PAGES frames zeroed ahead of use\n"
+			"                     (default 64, 0 disables).\n"
+			"  -rsslimit=PAGES    Limit each process to PAGES resident frames\n"
+			"                     unless it sets its own limit.\n"
+			"  -swap=C:D[:P],...  Swap to disk D of channel C with priority P\n"
+			"                     (default 0), striping runs across disks of\n"
+			"                     equal priority.  Disks are 1:1 and the extra\n"
+			"                     swap disks at 2:0, 2:1, 3:0 and 3:1\n"
+			"                     (default 1:1).\n"
+			"  -vmpolicy=POLICY   Replace pages with POLICY: clock (default),\n"
+			"                     2q or clockpro.\n"
 #endif
 			);
 	power_off ();
@@ -362,4 +417,11 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+	vm_policy_print_stats ();
+	swap_print_stats ();
+	zswap_print_stats ();
+	vm_file_print_stats ();
+#endif
 }
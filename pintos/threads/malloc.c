@@ -12,10 +12,12 @@
 /* A simple implementation of malloc().
 
    The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
+   of 2, or to 1.5 times a power of 2, and assigned to the
+   "descriptor" that manages blocks of that size.  The in-between
+   sizes keep a request just over a power of 2, such as a struct
+   page, from wasting almost half of its block.  The descriptor
+   keeps a list of free blocks.  If the free list is nonempty,
+   one of its blocks is used to satisfy the request.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
@@ -58,24 +60,33 @@ struct block {
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[20];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
+/* Adds the descriptor of BLOCK_SIZE-byte blocks, larger than
+   those of every descriptor added before. */
+static void
+desc_add (size_t block_size) {
+	struct desc *d = &descs[desc_cnt++];
+	ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+	d->block_size = block_size;
+	d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+	list_init (&d->free_list);
+	lock_init (&d->lock);
+}
+
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
 	size_t block_size;
 
 	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
-		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-		list_init (&d->free_list);
-		lock_init (&d->lock);
+		desc_add (block_size);
+		if (block_size + block_size / 2 < PGSIZE / 2)
+			desc_add (block_size + block_size / 2);
 	}
 }
 
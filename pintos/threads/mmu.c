@@ -8,11 +8,15 @@
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* A page directory entry that maps a huge page stands in for the page
+ * table entries of all of its pages: the walk returns the PDE itself. */
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
 	if (pdp) {
 		uint64_t *pte = (uint64_t *) pdp[idx];
+		if ((uint64_t) pte & PTE_P && (uint64_t) pte & PTE_PS)
+			return &pdp[idx];
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
 				uint64_t *new_page = palloc_get_page (PAL_ZERO);
@@ -169,7 +173,7 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (((uint64_t) pte) & PTE_P && !(((uint64_t) pte) & PTE_PS))
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -216,6 +220,8 @@ pml4_get_page (uint64_t *pml4, const void *uaddr) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
+	if (pte && (*pte & PTE_P) && (*pte & PTE_PS))
+		return ptov (PTE_ADDR (*pte) & ~HUGE_PGMASK) + ((uint64_t) uaddr & HUGE_PGMASK);
 	if (pte && (*pte & PTE_P))
 		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
 	return NULL;
@@ -238,11 +244,101 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, 1);
 
-	if (pte)
+	if (pte) {
+		ASSERT (!(*pte & PTE_PS));
 		*pte = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	}
 	return pte != NULL;
 }
 
+/* Returns the page directory entry for VA in PML4.  The tables
+ * above it are created if CREATE is true; otherwise, or if that
+ * fails, returns a null pointer when they are missing. */
+static uint64_t *
+pde_walk (uint64_t *pml4, uint64_t va, bool create) {
+	uint64_t *table = pml4;
+	unsigned idx[] = { PML4 (va), PDPE (va) };
+
+	for (unsigned i = 0; i < sizeof idx / sizeof *idx; i++) {
+		uint64_t *e = &table[idx[i]];
+		if (!(*e & PTE_P)) {
+			uint64_t *new_page = create ? palloc_get_page (PAL_ZERO) : NULL;
+			if (new_page == NULL)
+				return NULL;
+			*e = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		table = ptov (PTE_ADDR (*e));
+	}
+	return &table[PDX (va)];
+}
+
+/* Maps the huge page at user virtual address UPAGE in PML4 to the
+ * HUGE_PGCNT contiguous frames from kernel virtual address KPAGE on,
+ * with a single page directory entry.  Both addresses must be
+ * aligned to HUGE_PGSIZE.  A page table already covering UPAGE is
+ * freed, provided that none of its pages is mapped.  Returns false
+ * if some page is, or if memory allocation failed. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	uint64_t *pde;
+
+	ASSERT (((uint64_t) upage & HUGE_PGMASK) == 0);
+	ASSERT ((vtop (kpage) & HUGE_PGMASK) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	pde = pde_walk (pml4, (uint64_t) upage, true);
+	if (pde == NULL)
+		return false;
+	if (*pde & PTE_P) {
+		uint64_t *pt = ptov (PTE_ADDR (*pde));
+
+		if (*pde & PTE_PS)
+			return false;
+		for (unsigned i = 0; i < PGSIZE / sizeof (uint64_t); i++)
+			if (pt[i] & PTE_P)
+				return false;
+		palloc_free_page (pt);
+	}
+	*pde = vtop (kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	if (rcr3 () == vtop (pml4))
+		lcr3 (rcr3 ());
+	return true;
+}
+
+/* Returns true if UPAGE is part of a huge page mapped in PML4. */
+bool
+pml4_is_huge (uint64_t *pml4, const void *upage) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, false);
+	return pde != NULL && (*pde & PTE_P) && (*pde & PTE_PS);
+}
+
+/* Replaces the huge page mapping UPAGE in PML4, if any, by a page
+ * table mapping each of its pages to the same frame with the same
+ * permissions.  The accessed and dirty bits of the huge page are
+ * copied to every page.  Returns false if memory allocation
+ * failed. */
+bool
+pml4_split_huge (uint64_t *pml4, const void *upage) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, false);
+	uint64_t *pt, base, flags;
+
+	if (pde == NULL || !(*pde & PTE_P) || !(*pde & PTE_PS))
+		return true;
+	pt = palloc_get_page (0);
+	if (pt == NULL)
+		return false;
+
+	base = PTE_ADDR (*pde) & ~HUGE_PGMASK;
+	flags = *pde & (PTE_P | PTE_W | PTE_U | PTE_A | PTE_D);
+	for (unsigned i = 0; i < PGSIZE / sizeof (uint64_t); i++)
+		pt[i] = (base + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+	if (rcr3 () == vtop (pml4))
+		lcr3 (rcr3 ());
+	return true;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -256,12 +352,71 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
+		ASSERT (!(*pte & PTE_PS));
 		*pte &= ~PTE_P;
 		if (rcr3 () == vtop (pml4))
 			invlpg ((uint64_t) upage);
 	}
 }
 
+/* Undoes pml4_clear_page() on UPAGE, mapping it to KPAGE again with
+ * the writable, accessed and dirty bits it had.  Does nothing if UPAGE
+ * was not mapped to KPAGE. */
+void
+pml4_restore_page (uint64_t *pml4, void *upage, void *kpage) {
+	uint64_t *pte;
+	ASSERT (pg_ofs (upage) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	if (pte != NULL && PTE_ADDR (*pte) == vtop (kpage))
+		*pte |= PTE_P;
+}
+
+/* Initializes BATCH for clearing pages of PML4. */
+void
+tlb_batch_init (struct tlb_batch *batch, uint64_t *pml4) {
+	batch->pml4 = pml4;
+	batch->cnt = 0;
+}
+
+/* Like pml4_clear_page() on the page map of BATCH, but leaves the TLB
+   entry of UPAGE in place until tlb_batch_flush().  Until then the page
+   may still be reached through the TLB, so its frame must not be
+   reused. */
+void
+pml4_clear_page_batched (struct tlb_batch *batch, void *upage) {
+	uint64_t *pte;
+	ASSERT (pg_ofs (upage) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	pte = pml4e_walk (batch->pml4, (uint64_t) upage, false);
+
+	if (pte != NULL && (*pte & PTE_P) != 0) {
+		ASSERT (!(*pte & PTE_PS));
+		*pte &= ~PTE_P;
+		if (batch->cnt < TLB_BATCH_MAX)
+			batch->pages[batch->cnt] = upage;
+		batch->cnt++;
+	}
+}
+
+/* Invalidates the TLB entries of the pages cleared in BATCH: one by one
+   if there are at most TLB_BATCH_MAX of them, otherwise all at once by
+   reloading CR3.  Nothing needs doing if the page map is not active,
+   since activating it flushes the TLB. */
+void
+tlb_batch_flush (struct tlb_batch *batch) {
+	if (batch->cnt > 0 && rcr3 () == vtop (batch->pml4)) {
+		if (batch->cnt <= TLB_BATCH_MAX)
+			for (size_t i = 0; i < batch->cnt; i++)
+				invlpg ((uint64_t) batch->pages[i]);
+		else
+			lcr3 (rcr3 ());
+	}
+	batch->cnt = 0;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 is dirty,
  * that is, if the page has been modified since the PTE was
  * installed.
@@ -288,6 +443,32 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 	}
 }
 
+/* Returns true if the PTE for virtual page VPAGE in PML4 is present
+ * and writable. */
+bool
+pml4_is_writable (uint64_t *pml4, const void *vpage) {
+	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	return pte != NULL && (*pte & (PTE_P | PTE_W)) == (PTE_P | PTE_W);
+}
+
+/* Sets the writable bit to WRITABLE in the PTE for virtual page VPAGE
+ * in PML4.  Other bits in the page table entry, including the dirty
+ * and accessed bits, are preserved. */
+void
+pml4_set_writable (uint64_t *pml4, const void *vpage, bool writable) {
+	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+
+	if (pte) {
+		if (writable)
+			*pte |= PTE_W;
+		else
+			*pte &= ~(uint64_t) PTE_W;
+
+		if (rcr3 () == vtop (pml4))
+			invlpg ((uint64_t) vpage);
+	}
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 has been
  * accessed recently, that is, between the time the PTE was
  * installed and the last time it was cleared.  Returns false if
@@ -6,6 +6,7 @@
 #include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 
@@ -141,6 +142,11 @@ static void page_fault(struct intr_frame *f) {
   /* Count page faults. */
   page_fault_cnt++;
 
+  /* System calls check, copy in or pin user memory before they take
+     any lock, and exit on a bad pointer themselves, so a kernel fault
+     that cannot be resolved is a kernel bug, not the process's: exiting
+     here could leave a lock held. */
+
   /* If the fault is true fault, show info and exit. */
   //   system_exit(-1);
   //   printf("Page fault at %p: %s error %s page in %s context.\n", fault_addr,
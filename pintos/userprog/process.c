@@ -271,6 +271,7 @@ int process_exec(void *f_name) {
     memcpy(argv[i++], token, strlen(token) + 1);  // 값 옮겨 쓰기, 널 문자 포함해서 복사
   }
   argv[i] = NULL;  //마지막 인자는 무조건 NULL로 마무리
+  palloc_free_page(f_name);  // 인자는 모두 옮겨 썼으므로 복사본 해제
   /* argument parsing end */
 
   char *file_name = argv[0];
@@ -350,12 +351,12 @@ void process_exit(void) {
    * TODO: We recommend you to implement process resource cleanup here. */
 
   struct thread *curr = thread_current();
+  process_cleanup();  // text 페이지가 running_file을 참조하므로 먼저 정리
   if (curr->running_file) {
     file_allow_write(curr->running_file);
     file_close(curr->running_file);
     curr->running_file = NULL;
   }
-  process_cleanup();
 
   for (int i = 0; i <= curr->fd_max; i++) {
     if (!curr->fd_table[i]) continue;
@@ -381,6 +382,8 @@ static void process_cleanup(void) {
   struct thread *curr = thread_current();
 
 #ifdef VM
+  mmap_readahead_stop(curr);
+  mmap_writeback_all();
   supplemental_page_table_kill(&curr->spt);
 #endif
 
@@ -737,19 +740,11 @@ static bool lazy_load_segment(struct page *page, void *_aux) {
   /* TODO: Load the segment from the file */
   /* TODO: This called when the first page fault occurs on address VA. */
   /* TODO: VA is available when calling this function. */
-  struct load_aux *aux = _aux;
-  file_seek(aux->file, aux->seg_ofs);
-
-  // if (aux->)
-
-  if (file_read(aux->file, page->frame->kva, aux->read_bytes) != (int)aux->read_bytes) {
-    free(aux);
-    return false;
-  }
-  memset(page->frame->kva + aux->read_bytes, 0, aux->zero_bytes);
+  struct file_load_aux *aux = _aux;
+  bool succ = file_load_contents(aux, page->frame->kva);
 
   free(aux);
-  return true;
+  return succ;
 }
 
 /* Loads a segment starting at offset OFS in FILE at address
@@ -772,29 +767,26 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
   ASSERT(pg_ofs(upage) == 0);
   ASSERT(ofs % PGSIZE == 0);
 
-  while (read_bytes > 0 || zero_bytes > 0) {
-    /* Do calculate how to fill this page.
-     * We will read PAGE_READ_BYTES bytes from FILE
-     * and zero the final PAGE_ZERO_BYTES bytes. */
-    size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-    size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-    /* TODO: Set up aux to pass information to the lazy_load_segment. */
-    struct load_aux *aux = malloc(sizeof *aux);
-    aux->read_bytes = page_read_bytes;
-    aux->zero_bytes = page_zero_bytes;
-    aux->file = file;
-    aux->seg_ofs = ofs;
-    // aux->page_ofs =
-
-    if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, lazy_load_segment, aux))
-      return false;
-
-    /* Advance. */
-    read_bytes -= page_read_bytes;
-    zero_bytes -= page_zero_bytes;
-    upage += PGSIZE;
-    ofs += page_read_bytes;
+  /* The pages are created on first use, from the region. */
+  struct vma *vma = malloc(sizeof *vma);
+  if (vma == NULL) return false;
+  *vma = (struct vma){.start = upage,
+                      .end = upage + read_bytes + zero_bytes,
+                      .writable = writable,
+                      .file = file,
+                      .ofs = ofs,
+                      .read_bytes = read_bytes,
+                      .zero_anon = true};  // bss: 읽기는 공유 zero 프레임, 첫 쓰기에 프레임 할당
+  if (writable) {
+    vma->type = VM_ANON;
+    vma->init = lazy_load_segment;
+  } else {  // text: 같은 파일을 실행하는 프로세스끼리 프레임 공유
+    vma->type = VM_FILE | VM_TEXT;
+    vma->init = lazy_load_file;
+  }
+  if (!vma_insert(&thread_current()->spt, vma)) {
+    free(vma);
+    return false;
   }
   return true;
 }
@@ -9,6 +9,7 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
 #include "userprog/gdt.h"
 #include "userprog/process.h"
@@ -33,9 +34,15 @@ static unsigned system_tell(int fd);
 static int system_dup2(int oldfd, int newfd);
 static void *system_mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 static void system_munmap(void *addr);
+static int system_msync(void *addr, size_t length);
+static int system_vmstat(struct vmstat *stat, bool system);
+static int system_madvise(void *addr, size_t length, int advice);
+static int system_rsslimit(size_t pages);
 // static bool has_page(const char *buf);
 static bool validate_page_write(const char *buf);
+static bool user_addr_ok(const char *addr);
 static void validate_user_addr(const char *str);
+static char *copy_in_string(const char *ustr);
 static int expend_fd_table(struct thread *curr, size_t size);
 
 /* System call.
@@ -53,6 +60,12 @@ static int expend_fd_table(struct thread *curr, size_t size);
 
 struct lock filesys_lock; /* filesys 함수 접근 시 동기화 용 */
 
+/* Bytes of a user buffer that read() and write() pin at a time. The file
+ * system lock is released between chunks, so a read() or write() of more
+ * than PIN_CHUNK bytes is not atomic with respect to other readers and
+ * writers of the file: theirs may land between two of its chunks. */
+#define PIN_CHUNK (64 * PGSIZE)
+
 void syscall_init(void) {
   write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48 | ((uint64_t)SEL_KCSEG) << 32);
   write_msr(MSR_LSTAR, (uint64_t)syscall_entry);
@@ -120,6 +133,18 @@ void syscall_handler(struct intr_frame *f UNUSED) {
     case SYS_MUNMAP:
       system_munmap(f->R.rdi);
       break;
+    case SYS_MSYNC:
+      f->R.rax = system_msync((void *)f->R.rdi, f->R.rsi);
+      break;
+    case SYS_VMSTAT:
+      f->R.rax = system_vmstat((struct vmstat *)f->R.rdi, f->R.rsi);
+      break;
+    case SYS_MADVISE:
+      f->R.rax = system_madvise((void *)f->R.rdi, f->R.rsi, f->R.rdx);
+      break;
+    case SYS_RSSLIMIT:
+      f->R.rax = system_rsslimit(f->R.rdi);
+      break;
     default:
       printf("unknown! %d\n", f->R.rax);
       thread_exit();
@@ -158,6 +183,43 @@ static void system_munmap(void *addr) {
   do_munmap(m);
 }
 
+static int system_msync(void *addr, size_t length) {
+  if (addr == NULL || pg_ofs(addr) != 0 || !is_user_vaddr(addr) ||
+      !is_user_vaddr(addr + length) || addr + length < addr)
+    return -1;
+
+  return do_msync(addr, length) ? 0 : -1;
+}
+
+static int system_madvise(void *addr, size_t length, int advice) {
+  if (addr == NULL || pg_ofs(addr) != 0 || !is_user_vaddr(addr) ||
+      !is_user_vaddr(addr + length) || addr + length < addr)
+    return -1;
+
+  return do_madvise(addr, length, advice) ? 0 : -1;
+}
+
+/* Limits the current process to PAGES resident frames, or lifts its limit
+ * if PAGES is 0. The limit is kept across exec and inherited on fork. */
+static int system_rsslimit(size_t pages) {
+  vm_set_rss_limit(pages);
+  return 0;
+}
+
+/* Copies the counters of the current process, or of the whole system if
+ * SYSTEM, to STAT. */
+static int system_vmstat(struct vmstat *stat, bool system) {
+  char *last = (char *)stat + sizeof *stat - 1;
+
+  validate_user_addr((char *)stat);
+  validate_user_addr(last);
+  validate_page_write((char *)stat);
+  validate_page_write(last);
+
+  vm_get_stat(stat, system);
+  return 0;
+}
+
 static void system_halt(void) { power_off(); }
 void system_exit(int status) {
   /* child_list에 종료되었음을 기록, status, has_exited 등 */
@@ -185,37 +247,44 @@ void system_exit(int status) {
   thread_exit();
 }
 static pid_t system_fork(const char *thread_name, struct intr_frame *f) {
-  return process_fork(thread_name, f);
+  char *name = copy_in_string(thread_name);
+  pid_t pid = process_fork(name, f);
+
+  palloc_free_page(name);
+  return pid;
 }
 static int system_exec(const char *cmdd_line) {
-  validate_user_addr(cmdd_line);
-  int result = process_exec(cmdd_line);
+  int result = process_exec(copy_in_string(cmdd_line));  // 복사본은 process_exec가 해제
   system_exit(result);
   // never reached!!
   return result;  // 실패했을 경우에만 반환
 }
 static int system_wait(pid_t pid) { return process_wait(pid); }
 static bool system_create(const char *file, unsigned initial_size) {
-  validate_user_addr(file);  // file이 널 문자인지, 혹은 페이지 테이블에 없는 주소인지
-  // 대신에 락이 걸려야함
+  char *name = copy_in_string(file);  // 락을 잡기 전에 커널로 복사
   lock_acquire(&filesys_lock);                       // 동시접근을 막기 위해
-  bool result = filesys_create(file, initial_size);  // 파일 생성
+  bool result = filesys_create(name, initial_size);  // 파일 생성
   lock_release(&filesys_lock);
+  palloc_free_page(name);
   return result;  // 파일 생성이 성공적이면 true, 아니면 false
 }
 static bool system_remove(const char *file) {
-  validate_user_addr(file);  // file이 널 문자인지, 혹은 페이지 테이블에 없는 주소인지
+  char *name = copy_in_string(file);  // 락을 잡기 전에 커널로 복사
   lock_acquire(&filesys_lock);         // 동시접근을 막기 위해
-  bool result = filesys_remove(file);  // 파일 삭제
+  bool result = filesys_remove(name);  // 파일 삭제
   lock_release(&filesys_lock);
+  palloc_free_page(name);
   return result;  // 파일 삭제가 성공적이면 true, 아니면 false
 }
 static int system_open(const char *file) {
-  validate_user_addr(file);  // file 이 널문자인지, 혹은 페이지 테이블에 없는 주소인지
+  char *name = copy_in_string(file);  // 락을 잡기 전에 커널로 복사
   lock_acquire(&filesys_lock);                  // 동시접근을 막기 위해
-  struct file *open_file = filesys_open(file);  // 파일 열기
+  struct file *open_file = filesys_open(name);  // 파일 열기
   lock_release(&filesys_lock);
-  if (!open_file) return -1;  //파일 열기 실패 시 종료
+  if (!open_file) {  //파일 열기 실패 시 종료
+    palloc_free_page(name);
+    return -1;
+  }
 
   // fd 할당
   struct thread *curr = thread_current();
@@ -235,6 +304,7 @@ static int system_open(const char *file) {
       lock_acquire(&filesys_lock);
       file_close(open_file);  //파일 닫고
       lock_release(&filesys_lock);
+      palloc_free_page(name);
       return -1;  //-1 리턴하고 종료
     }
     new_fd = curr->fd_max + 1;  //확장 후 new_fd 설정
@@ -243,9 +313,10 @@ static int system_open(const char *file) {
 
   curr->fd_table[new_fd] = open_file;
   // rox 구현
-  if (!strcmp(curr->name, file))
+  if (!strcmp(curr->name, name))
     file_deny_write(open_file);  // 본인 자신을 열려고 하면 deny_write 설정
 
+  palloc_free_page(name);
   return new_fd;
 }
 static int system_filesize(int fd) {
@@ -276,9 +347,22 @@ static int system_read(int fd, void *buffer, unsigned size) {
   } else {
     struct file *read_file = curr->fd_table[fd];
     if (!read_file) return -1;
-    lock_acquire(&filesys_lock);  // 동시접근을 막기 위해
-    read_bytes = file_read(read_file, buffer, size);
-    lock_release(&filesys_lock);
+    read_bytes = 0;
+    // PIN_CHUNK씩 나눠 읽으므로 큰 read 사이에 다른 writer가 끼어들 수 있음
+    while ((unsigned)read_bytes < size) {
+      uint8_t *buf = (uint8_t *)buffer + read_bytes;
+      unsigned chunk = size - read_bytes < PIN_CHUNK ? size - read_bytes : PIN_CHUNK;
+      int n;
+
+      // 락을 쥔 채 폴트가 나지 않도록 버퍼를 먼저 올려서 고정
+      if (!vm_pin_buffer(buf, chunk, true)) system_exit(-1);
+      lock_acquire(&filesys_lock);  // 동시접근을 막기 위해
+      n = file_read(read_file, buf, chunk);
+      lock_release(&filesys_lock);
+      vm_unpin_buffer(buf, chunk);
+      read_bytes += n;
+      if ((unsigned)n != chunk) break;
+    }
   }
 
   return read_bytes;
@@ -289,18 +373,38 @@ static int system_write(int fd, const void *buffer, unsigned size) {
   validate_user_addr(buffer);
 
   if (curr->fd_table[fd] == get_std_out()) {  // 표준 출력일 경우
-    putbuf(buffer, size);
+    // 콘솔 락을 쥔 채 폴트가 나지 않도록 PIN_CHUNK씩 먼저 고정
+    for (unsigned done = 0; done < size; done += PIN_CHUNK) {
+      const char *buf = (const char *)buffer + done;
+      unsigned chunk = size - done < PIN_CHUNK ? size - done : PIN_CHUNK;
+
+      if (!vm_pin_buffer(buf, chunk, false)) system_exit(-1);
+      putbuf(buf, chunk);
+      vm_unpin_buffer(buf, chunk);
+    }
     return size;
   } else if (curr->fd_table[fd] == get_std_in()) {  //표준 입력일 경우 잘못된 접근이므로 -1 리턴
     return -1;
   } else {
-    int write_bytes;
+    int write_bytes = 0;
     struct file *write_file = curr->fd_table[fd];
     if (!write_file) return -1;
     if (write_file->deny_write) return 0;
-    lock_acquire(&filesys_lock);  // 동시접근을 막기 위해
-    write_bytes = file_write(write_file, buffer, size);
-    lock_release(&filesys_lock);
+    // PIN_CHUNK씩 나눠 쓰므로 큰 write는 다른 writer와 섞일 수 있음
+    while ((unsigned)write_bytes < size) {
+      const uint8_t *buf = (const uint8_t *)buffer + write_bytes;
+      unsigned chunk = size - write_bytes < PIN_CHUNK ? size - write_bytes : PIN_CHUNK;
+      int n;
+
+      // 락을 쥔 채 폴트가 나지 않도록 버퍼를 먼저 올려서 고정
+      if (!vm_pin_buffer(buf, chunk, false)) system_exit(-1);
+      lock_acquire(&filesys_lock);  // 동시접근을 막기 위해
+      n = file_write(write_file, buf, chunk);
+      lock_release(&filesys_lock);
+      vm_unpin_buffer(buf, chunk);
+      write_bytes += n;
+      if ((unsigned)n != chunk) break;
+    }
     return write_bytes;
   }
 }
@@ -390,26 +494,43 @@ static bool validate_page_write(const char *buf) {
   }
 }
 
-static void validate_user_addr(const char *addr) {
-  if (addr == NULL || !is_user_vaddr(addr)) {  //주소가 NULL이거나, kernel 영역이거나
-    system_exit(-1);                           // 종료
-  }
+/* Returns true if the process may read ADDR: a user address with a page,
+ * or one the stack may grow to. */
+static bool user_addr_ok(const char *addr) {
+  if (addr == NULL || !is_user_vaddr(addr)) return false;  //주소가 NULL이거나, kernel 영역이거나
 
 #ifdef VM
   struct page *p = spt_find_page(&thread_current()->spt, addr);
   bool has_page = p != NULL;
-  // 페이지테이블에도 없고, 스택 성장도 불가하면 종료
-  if (!has_page && !valid_stack_growth(addr, NULL, false)) {
-    system_exit(-1);  //종료
-  }
-
+  // 페이지테이블에도 없고, 스택 성장도 불가하면 실패
+  return has_page || valid_stack_growth(addr, NULL, false);
 #else
   // 해당 프로세스의 page테이블에 등록되어 있지 않는 주소라면
-  if (pml4_get_page(thread_current()->pml4, str) == NULL) {
-    system_exit(-1);  //종료
-  }
+  return pml4_get_page(thread_current()->pml4, addr) != NULL;
 #endif
 }
+static void validate_user_addr(const char *addr) {
+  if (!user_addr_ok(addr)) system_exit(-1);  // 종료
+}
+
+/* Copies the user string USTR into a new page, cut short to PGSIZE - 1
+ * bytes, and returns the page, which the caller frees. Exits if USTR runs
+ * into memory the process may not read. Callers copy before taking any
+ * lock, so that a bad string never faults with a lock held. */
+static char *copy_in_string(const char *ustr) {
+  char *kstr = palloc_get_page(0);
+
+  if (kstr == NULL) system_exit(-1);
+  for (size_t i = 0; i < PGSIZE - 1; i++) {
+    if ((i == 0 || pg_ofs(ustr + i) == 0) && !user_addr_ok(ustr + i)) {
+      palloc_free_page(kstr);
+      system_exit(-1);
+    }
+    if ((kstr[i] = ustr[i]) == '\0') return kstr;
+  }
+  kstr[PGSIZE - 1] = '\0';
+  return kstr;
+}
 static int expend_fd_table(struct thread *curr, size_t size) {  // MAXFILES의 배수로 ㄱㄱ
   // if (curr->fd_size >= 512) return -1;                          //크기 제한
   size_t size_cnt = size / MAX_FILES + 1;
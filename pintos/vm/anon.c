@@ -1,20 +1,123 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "devices/disk.h"
 #include "include/threads/vaddr.h"
 #include "kernel/bitmap.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
 #include "vm/vm.h"
+#include "vm/zswap.h"
 
 #define SEC_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
 #define SEC_NO(SLOT_NO) ((SLOT_NO)*SEC_PER_PAGE)
 
+/* Slot number of a page that was all zeros when swapped out. It takes
+ * neither a slot nor any disk I/O. */
+#define SLOT_ZERO (BITMAP_ERROR - 1)
+
 /* DO NOT MODIFY BELOW LINE */
-static struct disk *swap_disk;
 static struct bitmap *swap_bitmap;
 static bool anon_swap_in(struct page *page, void *kva);
 static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
 
+/* Number of pages referring to each swap slot. A slot is shared when a
+ * copy-on-write frame is evicted while several processes still map it. */
+static uint16_t *slot_refs;
+static struct lock swap_lock;
+
+/* Slot allocation. Swap is divided into clusters of SWAP_CLUSTER slots,
+ * aligned. Clusters with no slot in use are kept on the free list and
+ * partly used ones on the partial list, both doubly linked through cluster
+ * indexes. Taking a fresh cluster, finding a free slot anywhere and
+ * releasing a slot therefore take constant time however large swap is.
+ * SWAP_BITMAP still tells which slots of a cluster are in use. */
+#define CLUSTER_NONE UINT32_MAX
+
+struct cluster {
+  uint32_t prev, next; /* Neighbours on the list of its state. */
+  uint16_t used;       /* Slots in use. */
+  uint8_t dev;         /* Index of its device in swap_devs. */
+};
+
+struct cluster_list {
+  uint32_t head;
+  size_t cnt;
+};
+
+static struct cluster *clusters; /* Protected by swap_lock, like the lists. */
+static size_t cluster_cnt;
+static struct cluster_list partial_clusters;
+static size_t used_slots, peak_slots;
+
+/* Swap devices. Slot numbers run across all of them, each device holding
+ * a range of whole clusters, and each keeps its own free list. A fresh
+ * cluster comes from the device of highest priority that has one; devices
+ * of equal priority take turns, so that runs swapped out one after another
+ * are striped across disks and, on different channels, move at the same
+ * time. Without -swap, the only device is hd1:1. */
+#define SWAP_DEV_MAX 4
+
+struct swap_dev {
+  int chan_no, dev_no;      /* Disk, from -swap. */
+  int prio;
+  struct disk *disk;
+  size_t first;             /* First cluster. */
+  size_t cnt;               /* Number of clusters. */
+  struct cluster_list free; /* Its clusters with no slot in use. */
+};
+
+static struct swap_dev swap_devs[SWAP_DEV_MAX] = {{.chan_no = 1, .dev_no = 1}};
+static size_t swap_dev_cnt = 1;
+static size_t swap_dev_hand; /* Device that gave the latest fresh cluster. */
+
+static void swap_write_back(size_t slot, const void *kva);
+
+/* Clustering. A page goes to the slot at its own offset in the cluster of
+ * its run, so pages next to each other in a process's address space are
+ * next to each other in swap too, in whatever order they get evicted.
+ * Each process remembers the clusters of the last SWAP_CLUSTER_CACHE runs
+ * it swapped out, which serve as its cache of slots. A page gets another
+ * free slot, nearby if possible, when its slot in the cluster is taken or
+ * no free cluster is left. */
+
+/* Read-ahead. A fault that has to read a page from swap also queues the
+ * other swapped-out pages of the run for the read-ahead thread. It reads
+ * them into free frames, one disk command per run of consecutive slots,
+ * and keeps the frames in the swap cache. A later fault on one of those
+ * pages only installs the frame. Each cache entry holds a reference to its
+ * slot, so the slot keeps its contents as long as the entry exists. */
+#define SWAP_CACHE_SIZE 64
+
+struct swap_cache_entry {
+  size_t slot;         /* BITMAP_ERROR if the entry is free. */
+  struct frame *frame; /* Pinned and without pages, NULL while being read. */
+};
+
+/* Slots of one run to read ahead. */
+struct swap_ra_request {
+  struct list_elem elem;
+  size_t cnt;
+  size_t slots[SWAP_CLUSTER];
+};
+
+static struct swap_cache_entry swap_cache[SWAP_CACHE_SIZE]; /* Protected by swap_lock. */
+static size_t swap_cache_hand;
+static struct condition swap_cache_cond; /* Signaled when reads finish. */
+static struct list swap_ra_queue;        /* Protected by swap_lock. */
+static struct semaphore swap_ra_sema;    /* Counts the requests in swap_ra_queue. */
+
+static void swap_ra_thread(void *aux UNUSED);
+
+/* Statistics. */
+static long long clustered_cnt, scattered_cnt;
+static long long ra_read_cnt, ra_hit_cnt, ra_wasted_cnt;
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
     .swap_in = anon_swap_in,
@@ -23,13 +126,297 @@ static const struct page_operations anon_ops = {
     .type = VM_ANON,
 };
 
+static void cluster_push(struct cluster_list *list, uint32_t c) {
+  clusters[c].prev = CLUSTER_NONE;
+  clusters[c].next = list->head;
+  if (list->head != CLUSTER_NONE) clusters[list->head].prev = c;
+  list->head = c;
+  list->cnt++;
+}
+
+static void cluster_unlink(struct cluster_list *list, uint32_t c) {
+  if (clusters[c].prev != CLUSTER_NONE)
+    clusters[clusters[c].prev].next = clusters[c].next;
+  else
+    list->head = clusters[c].next;
+  if (clusters[c].next != CLUSTER_NONE) clusters[clusters[c].next].prev = clusters[c].prev;
+  list->cnt--;
+}
+
+/* Returns the list of clusters with USED slots in use, or NULL for full
+ * clusters, which are on no list. */
+static struct cluster_list *cluster_list_of(uint32_t c, uint16_t used) {
+  return used == 0 ? &swap_devs[clusters[c].dev].free
+                   : used < SWAP_CLUSTER ? &partial_clusters : NULL;
+}
+
+/* Moves cluster C to the list of its state after its count of used slots
+ * changed from OLD. */
+static void cluster_update(uint32_t c, uint16_t old) {
+  struct cluster_list *from = cluster_list_of(c, old), *to = cluster_list_of(c, clusters[c].used);
+
+  if (from == to) return;
+  if (from != NULL) cluster_unlink(from, c);
+  if (to != NULL) cluster_push(to, c);
+}
+
+/* Marks the free SLOT used. Must be called with swap_lock held. */
+static void slot_mark(size_t slot) {
+  uint32_t c = slot / SWAP_CLUSTER;
+
+  ASSERT(!bitmap_test(swap_bitmap, slot));
+  bitmap_mark(swap_bitmap, slot);
+  cluster_update(c, clusters[c].used++);
+  if (++used_slots > peak_slots) peak_slots = used_slots;
+}
+
+/* Marks the used SLOT free. Must be called with swap_lock held. */
+static void slot_unmark(size_t slot) {
+  uint32_t c = slot / SWAP_CLUSTER;
+
+  ASSERT(bitmap_test(swap_bitmap, slot));
+  bitmap_reset(swap_bitmap, slot);
+  cluster_update(c, clusters[c].used--);
+  used_slots--;
+}
+
+/* Returns true if disk CHAN:DEV is a dedicated swap disk: hd1:1, or one
+ * of the extra ones the pintos utility attaches at hd2 and hd3. The other
+ * disks hold the kernel, the file system and the scratch disk. */
+static bool swap_disk_ok(int chan_no, int dev_no) {
+  if (dev_no != 0 && dev_no != 1) return false;
+  return (chan_no == 1 && dev_no == 1) || chan_no == 2 || chan_no == 3;
+}
+
+/* Sets the swap devices from SPEC, a comma-separated list of CHAN:DEV or
+ * CHAN:DEV:PRIO, e.g. "1:1,2:0" or "1:1:1,2:0,2:1". Must be called before
+ * vm_init(). Returns false if SPEC is malformed or names a disk that is
+ * not a swap disk. */
+bool swap_parse_devices(char *spec) {
+  char *dev_spec, *save;
+  size_t cnt = 0;
+
+  for (dev_spec = strtok_r(spec, ",", &save); dev_spec != NULL;
+       dev_spec = strtok_r(NULL, ",", &save)) {
+    char *chan = dev_spec, *dev = strchr(chan, ':'), *prio;
+
+    if (dev == NULL || cnt == SWAP_DEV_MAX) return false;
+    *dev++ = '\0';
+    if ((prio = strchr(dev, ':')) != NULL) *prio++ = '\0';
+    swap_devs[cnt] = (struct swap_dev){
+        .chan_no = atoi(chan), .dev_no = atoi(dev), .prio = prio != NULL ? atoi(prio) : 0};
+    if (!swap_disk_ok(swap_devs[cnt].chan_no, swap_devs[cnt].dev_no)) return false;
+    for (size_t i = 0; i < cnt; i++)
+      if (swap_devs[i].chan_no == swap_devs[cnt].chan_no &&
+          swap_devs[i].dev_no == swap_devs[cnt].dev_no)
+        return false;
+    cnt++;
+  }
+  if (cnt == 0) return false;
+  swap_dev_cnt = cnt;
+  return true;
+}
+
+/* Returns the device to take a fresh cluster from, or NULL if every device
+ * is full. Must be called with swap_lock held. */
+static struct swap_dev *swap_dev_pick(void) {
+  struct swap_dev *best = NULL;
+
+  // 마지막으로 쓴 장치 다음부터 돌아서 같은 우선순위끼리 번갈아 씀
+  for (size_t n = 1; n <= swap_dev_cnt; n++) {
+    struct swap_dev *d = &swap_devs[(swap_dev_hand + n) % swap_dev_cnt];
+    if (d->free.head != CLUSTER_NONE && (best == NULL || d->prio > best->prio)) best = d;
+  }
+  if (best != NULL) swap_dev_hand = best - swap_devs;
+  return best;
+}
+
 /* Initialize the data for anonymous pages */
 void vm_anon_init(void) {
   /* TODO: Set up the swap_disk. */
-  swap_disk = disk_get(1, 1);  // 실패시 panic
+  cluster_cnt = 0;
+  for (size_t i = 0; i < swap_dev_cnt; i++) {
+    struct swap_dev *d = &swap_devs[i];
 
-  size_t slot_len = disk_size(swap_disk) / SEC_PER_PAGE;
+    d->disk = disk_get(d->chan_no, d->dev_no);
+    if (d->disk == NULL) PANIC("vm_anon_init: no swap disk hd%d:%d", d->chan_no, d->dev_no);
+    d->first = cluster_cnt;
+    d->cnt = disk_size(d->disk) / SEC_PER_PAGE / SWAP_CLUSTER;
+    cluster_cnt += d->cnt;
+  }
+  size_t slot_len = cluster_cnt * SWAP_CLUSTER;
   swap_bitmap = bitmap_create(slot_len);
+  slot_refs = calloc(slot_len, sizeof *slot_refs);
+  clusters = calloc(cluster_cnt, sizeof *clusters);
+  if (swap_bitmap == NULL || slot_refs == NULL || clusters == NULL)
+    PANIC("vm_anon_init: out of memory");
+  partial_clusters = (struct cluster_list){.head = CLUSTER_NONE};
+  for (size_t i = 0; i < swap_dev_cnt; i++) {
+    struct swap_dev *d = &swap_devs[i];
+
+    d->free = (struct cluster_list){.head = CLUSTER_NONE};
+    for (size_t c = d->first + d->cnt; c-- > d->first;) {
+      clusters[c].dev = i;
+      cluster_push(&d->free, c);
+    }
+  }
+  swap_dev_hand = swap_dev_cnt - 1;
+  lock_init(&swap_lock);
+  zswap_init(swap_write_back);
+
+  for (size_t i = 0; i < SWAP_CACHE_SIZE; i++) swap_cache[i].slot = BITMAP_ERROR;
+  cond_init(&swap_cache_cond);
+  list_init(&swap_ra_queue);
+  sema_init(&swap_ra_sema, 0);
+  thread_create("swapra", PRI_DEFAULT, swap_ra_thread, NULL);
+}
+
+/* Drops one reference to SLOT and releases it when nobody uses it anymore.
+ * Must be called with swap_lock held. */
+static void slot_release(size_t slot) {
+  ASSERT(slot_refs[slot] > 0);
+  if (--slot_refs[slot] == 0) {
+    zswap_invalidate(slot);
+    slot_unmark(slot);
+  }
+}
+
+static void slot_put(size_t slot) {
+  lock_acquire(&swap_lock);
+  slot_release(slot);
+  lock_release(&swap_lock);
+}
+
+/* Allocates a slot for PAGE, in the cluster of its run if possible.
+ * Must be called with swap_lock held. Returns BITMAP_ERROR if swap is
+ * full. */
+static size_t slot_alloc(struct page *page) {
+  struct supplemental_page_table *spt = page->spt;
+  uintptr_t run = pg_no(page->va) / SWAP_CLUSTER;
+  size_t slot, base;
+  struct swap_cluster *c = NULL;
+  struct swap_dev *dev;
+
+  for (size_t i = 0; i < spt->swap_cluster_cnt && c == NULL; i++)
+    if (spt->swap_clusters[i].run == run) c = &spt->swap_clusters[i];
+  if (c == NULL && (dev = swap_dev_pick()) != NULL) {
+    base = (size_t)dev->free.head * SWAP_CLUSTER;
+    if (spt->swap_cluster_cnt < SWAP_CLUSTER_CACHE) {
+      c = &spt->swap_clusters[spt->swap_cluster_cnt++];
+    } else {
+      c = &spt->swap_clusters[spt->swap_cluster_hand];
+      spt->swap_cluster_hand = (spt->swap_cluster_hand + 1) % SWAP_CLUSTER_CACHE;
+    }
+    *c = (struct swap_cluster){.run = run, .base = base};
+  }
+
+  slot = c != NULL ? c->base + pg_no(page->va) % SWAP_CLUSTER : BITMAP_ERROR;
+  if (slot != BITMAP_ERROR && !bitmap_test(swap_bitmap, slot)) {
+    slot_mark(slot);
+    clustered_cnt++;
+    return slot;
+  }
+
+  // 자리가 찼으면 같은 클러스터의 빈 슬롯, 일부만 쓰인 클러스터, 빈 클러스터 순
+  if (c != NULL && clusters[c->base / SWAP_CLUSTER].used < SWAP_CLUSTER)
+    slot = bitmap_scan(swap_bitmap, c->base, 1, false);
+  else if (partial_clusters.head != CLUSTER_NONE)
+    slot = bitmap_scan(swap_bitmap, (size_t)partial_clusters.head * SWAP_CLUSTER, 1, false);
+  else if ((dev = swap_dev_pick()) != NULL)
+    slot = (size_t)dev->free.head * SWAP_CLUSTER;
+  else
+    return BITMAP_ERROR;
+  slot_mark(slot);
+  scattered_cnt++;
+  return slot;
+}
+
+/* Returns the cache entry of SLOT, or NULL. Must be called with swap_lock
+ * held. */
+static struct swap_cache_entry *swap_cache_find(size_t slot) {
+  for (size_t i = 0; i < SWAP_CACHE_SIZE; i++)
+    if (swap_cache[i].slot == slot) return &swap_cache[i];
+  return NULL;
+}
+
+/* Frees entry E, which has been read, and stores its frame in *FRAME for
+ * the caller to free once it has released swap_lock. */
+static void swap_cache_drop(struct swap_cache_entry *e, struct frame **frame) {
+  ASSERT(e->frame != NULL);
+  *frame = e->frame;
+  slot_release(e->slot);
+  *e = (struct swap_cache_entry){.slot = BITMAP_ERROR};
+  ra_wasted_cnt++;
+}
+
+/* Returns a free cache entry, dropping one that has been read if there is
+ * none, or NULL if every entry is being read. */
+static struct swap_cache_entry *swap_cache_alloc(struct frame **victim) {
+  struct swap_cache_entry *e = swap_cache_find(BITMAP_ERROR);
+
+  for (size_t n = 0; e == NULL && n < SWAP_CACHE_SIZE; n++) {
+    struct swap_cache_entry *c = &swap_cache[swap_cache_hand];
+
+    swap_cache_hand = (swap_cache_hand + 1) % SWAP_CACHE_SIZE;
+    if (c->frame != NULL && *victim == NULL) {
+      swap_cache_drop(c, victim);
+      e = c;
+    }
+  }
+  return e;
+}
+
+/* Returns the device of SLOT and stores in *CNT how many of the CNT slots
+ * from SLOT on it holds, and in *SEC_NO the sector of SLOT on it. */
+static struct swap_dev *slot_dev(size_t slot, size_t *cnt, disk_sector_t *sec_no) {
+  struct swap_dev *d = &swap_devs[clusters[slot / SWAP_CLUSTER].dev];
+  size_t left = (d->first + d->cnt) * SWAP_CLUSTER - slot;
+
+  if (*cnt > left) *cnt = left;
+  *sec_no = SEC_NO(slot - d->first * SWAP_CLUSTER);
+  return d;
+}
+
+/* Reads the CNT pages kept in consecutive slots from SLOT on into KVAS.
+ * The whole run moves with a single multi-sector command per
+ * DISK_MAX_XFER sectors instead of one command per sector, or one per
+ * device if the run spans two. */
+static void swap_read_pages(size_t slot, void *const kvas[], size_t cnt) {
+  while (cnt > 0) {
+    size_t n = cnt;
+    disk_sector_t sec_no;
+    struct swap_dev *d = slot_dev(slot, &n, &sec_no);
+
+    disk_read_scatter(d->disk, sec_no, kvas, n, SEC_PER_PAGE);
+    slot += n, kvas += n, cnt -= n;
+  }
+}
+
+/* Writes the CNT pages of KVAS into consecutive slots from SLOT on. */
+static void swap_write_pages(size_t slot, const void *const kvas[], size_t cnt) {
+  while (cnt > 0) {
+    size_t n = cnt;
+    disk_sector_t sec_no;
+    struct swap_dev *d = slot_dev(slot, &n, &sec_no);
+
+    disk_write_gather(d->disk, sec_no, kvas, n, SEC_PER_PAGE);
+    slot += n, kvas += n, cnt -= n;
+  }
+}
+
+/* Writes a page evicted from the compressed pool to its slot. */
+static void swap_write_back(size_t slot, const void *kva) {
+  const void *kvas[] = {kva};
+  swap_write_pages(slot, kvas, 1);
+}
+
+/* Returns true if the page at KVA contains only zeros. */
+static bool page_is_zero(const void *kva) {
+  const uint64_t *p = kva;
+
+  for (size_t i = 0; i < PGSIZE / sizeof *p; i++)
+    if (p[i] != 0) return false;
+  return true;
 }
 
 /* Initialize the file mapping */
@@ -39,23 +426,50 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva) {
   struct anon_page *anon_page = &page->anon;
 
   anon_page->slot = BITMAP_ERROR;  // slot_no 초기화
+  anon_page->cached = false;
 
   return true;
 }
 
+/* Makes DST refer to the swap slot of SRC, both being swapped-out anonymous
+ * pages with identical contents (fork of a swapped-out page). */
+void anon_dup_slot(struct page *dst, struct page *src) {
+  size_t slot = src->anon.slot;
+
+  ASSERT(slot != BITMAP_ERROR);
+  dst->anon.slot = slot;
+  if (slot == SLOT_ZERO) return;
+
+  lock_acquire(&swap_lock);
+  ASSERT(slot_refs[slot] > 0 && slot_refs[slot] < UINT16_MAX);
+  slot_refs[slot]++;
+  lock_release(&swap_lock);
+}
+
 /* Swap in the page by read contents from the swap disk. */
 static bool anon_swap_in(struct page *page, void *kva) {
   struct anon_page *anon_page = &page->anon;
 
-  // disk to memory
-  disk_sector_t sec_base = SEC_NO(anon_page->slot);
-  uint8_t *va = page->frame->kva;
-  for (size_t i = 0; i < SEC_PER_PAGE; i++) {
-    size_t done = DISK_SECTOR_SIZE * i;
-    disk_read(swap_disk, sec_base + i, va + done);
+  if (anon_page->slot == BITMAP_ERROR) return false;
+  if (anon_page->slot == SLOT_ZERO) {
+    memset(kva, 0, PGSIZE);
+    anon_page->slot = BITMAP_ERROR;
+    return true;
+  }
+
+  // disk to memory, unless the compressed pool or the swap cache has it
+  if (anon_page->cached) {
+    anon_page->cached = false;
+  } else {
+    if (!zswap_load(anon_page->slot, page->frame->kva)) {
+      void *kvas[] = {page->frame->kva};
+      swap_read_pages(anon_page->slot, kvas, 1);
+    }
+    vm_stat_inc(page->spt, swap_ins);
   }
-  bitmap_set(swap_bitmap, anon_page->slot, false);
+  slot_put(anon_page->slot);
   anon_page->slot = BITMAP_ERROR;
+  return true;
 }
 
 /* Swap out the page by writing contents to the swap disk. */
@@ -63,25 +477,195 @@ static bool anon_swap_out(struct page *page) {
   struct anon_page *anon_page = &page->anon;
 
   if (anon_page->slot != BITMAP_ERROR) return false;
+  if (page_is_zero(page->frame->kva)) {  // 0으로만 채워진 페이지는 슬롯 없이 기록
+    anon_page->slot = SLOT_ZERO;
+    return true;
+  }
 
-  size_t slot = bitmap_scan_and_flip(swap_bitmap, 0, 1, false);
+  lock_acquire(&swap_lock);
+  size_t slot = slot_alloc(page);
+  if (slot != BITMAP_ERROR) slot_refs[slot] = 1;
+  lock_release(&swap_lock);
   if (slot == BITMAP_ERROR) {
     return false;
   }
   anon_page->slot = slot;
+  vm_stat_inc(page->spt, swap_outs);
 
-  // memory to disk
-  disk_sector_t sec_base = SEC_NO(anon_page->slot);
-  uint8_t *va = page->frame->kva;
-  for (size_t i = 0; i < SEC_PER_PAGE; i++) {
-    size_t done = i * DISK_SECTOR_SIZE;
-    disk_write(swap_disk, sec_base + i, va + done);
-  }
+  // memory to the compressed pool, or to disk if it does not take it
+  if (!zswap_store(anon_page->slot, page->frame->kva))
+    swap_write_back(anon_page->slot, page->frame->kva);
   return true;
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void anon_destroy(struct page *page) {
   struct anon_page *anon_page = &page->anon;
-  // anon_page - 클린업 해야할때
+  struct swap_cache_entry *e;
+  struct frame *frame = NULL;
+
+  // 스왑 아웃된 채로 죽는 페이지는 슬롯 반환, 미리 읽어 둔 내용도 버림
+  if (anon_page->slot != BITMAP_ERROR && anon_page->slot != SLOT_ZERO) {
+    lock_acquire(&swap_lock);
+    e = swap_cache_find(anon_page->slot);
+    if (e != NULL && e->frame != NULL) swap_cache_drop(e, &frame);
+    slot_release(anon_page->slot);
+    lock_release(&swap_lock);
+    if (frame != NULL) vm_free_frame(frame);
+  }
+  anon_page->slot = BITMAP_ERROR;
+}
+
+/* Releases the swap slots of those of the CNT PAGES, about to be destroyed,
+ * that are swapped out, under a single hold of the swap lock. Slots whose
+ * contents sit in the swap cache are left to anon_destroy(). */
+void anon_release_slots(struct page *pages[], size_t cnt) {
+  lock_acquire(&swap_lock);
+  for (size_t i = 0; i < cnt; i++) {
+    struct page *p = pages[i];
+    struct swap_cache_entry *e;
+    size_t slot;
+
+    if (VM_TYPE(p->operations->type) != VM_ANON || p->frame != NULL) continue;
+    slot = p->anon.slot;
+    if (slot == BITMAP_ERROR || slot == SLOT_ZERO) continue;
+    e = swap_cache_find(slot);
+    if (e != NULL && e->frame != NULL) continue;
+    slot_release(slot);
+    p->anon.slot = BITMAP_ERROR;
+  }
+  lock_release(&swap_lock);
+}
+
+/* Queues the other swapped-out pages of the run of PAGE, a page of the
+ * current process, for the read-ahead thread. */
+static void swap_ra_issue(struct page *page) {
+  uint8_t *run = (uint8_t *)((uintptr_t)page->va & ~((uintptr_t)SWAP_CLUSTER * PGSIZE - 1));
+  struct swap_ra_request *req = malloc(sizeof *req);
+  struct frame *victim = NULL;
+
+  if (req == NULL) return;
+  req->cnt = 0;
+  lock_acquire(&swap_lock);
+  for (size_t i = 0; i < SWAP_CLUSTER; i++) {
+    struct page *p = spt_lookup_page(page->spt, run + i * PGSIZE);
+    struct swap_cache_entry *e;
+    size_t slot;
+
+    // 내보내기가 끝나 슬롯에만 내용이 있는 이웃 페이지만 읽음
+    if (p == NULL || p == page || VM_TYPE(p->operations->type) != VM_ANON || p->frame != NULL)
+      continue;
+    slot = p->anon.slot;
+    if (slot == BITMAP_ERROR || slot == SLOT_ZERO || swap_cache_find(slot) != NULL ||
+        slot_refs[slot] == UINT16_MAX)
+      continue;
+    if ((e = swap_cache_alloc(&victim)) == NULL) break;
+    e->slot = slot;
+    slot_refs[slot]++;
+    req->slots[req->cnt++] = slot;
+  }
+  if (req->cnt > 0) list_push_back(&swap_ra_queue, &req->elem);
+  lock_release(&swap_lock);
+
+  if (victim != NULL) vm_free_frame(victim);
+  if (req->cnt > 0)
+    sema_up(&swap_ra_sema);
+  else
+    free(req);
+}
+
+/* Called on a fault on PAGE, a swapped-out anonymous page of the current
+ * process. Returns the frame its slot was read ahead into, pinned and
+ * without pages, or NULL. Swapping PAGE in to that frame reads nothing.
+ * Otherwise queues the neighbours of PAGE for reading ahead. */
+struct frame *swap_readahead(struct page *page) {
+  size_t slot = page->anon.slot;
+  struct swap_cache_entry *e;
+  struct frame *frame = NULL;
+
+  if (slot == BITMAP_ERROR || slot == SLOT_ZERO) return NULL;
+  lock_acquire(&swap_lock);
+  while ((e = swap_cache_find(slot)) != NULL && e->frame == NULL)
+    cond_wait(&swap_cache_cond, &swap_lock);
+  if (e != NULL) {
+    frame = e->frame;
+    slot_release(slot);  // 엔트리의 참조만 반환, 페이지의 참조는 swap-in에서
+    *e = (struct swap_cache_entry){.slot = BITMAP_ERROR};
+    page->anon.cached = true;
+    ra_hit_cnt++;
+  }
+  lock_release(&swap_lock);
+
+  if (frame == NULL) swap_ra_issue(page);
+  return frame;
+}
+
+/* Reads the queued runs ahead of use. */
+static void swap_ra_thread(void *aux UNUSED) {
+  for (;;) {
+    struct swap_ra_request *req;
+    struct frame *frames[SWAP_CLUSTER];
+    void *kvas[SWAP_CLUSTER];
+    bool loaded[SWAP_CLUSTER];
+    size_t cnt, i, j;
+
+    sema_down(&swap_ra_sema);
+    lock_acquire(&swap_lock);
+    req = list_entry(list_pop_front(&swap_ra_queue), struct swap_ra_request, elem);
+    lock_release(&swap_lock);
+
+    // 빈 프레임이 없으면 나머지는 읽지 않음
+    for (cnt = 0; cnt < req->cnt && (frames[cnt] = vm_alloc_frame()) != NULL; cnt++) {
+      kvas[cnt] = frames[cnt]->kva;
+      loaded[cnt] = zswap_load(req->slots[cnt], kvas[cnt]);
+    }
+    for (i = 0; i < cnt; i = j) {
+      for (j = i + 1; j < cnt && !loaded[i] && !loaded[j] && req->slots[j] == req->slots[j - 1] + 1;
+           j++)
+        continue;
+      if (!loaded[i]) swap_read_pages(req->slots[i], kvas + i, j - i);
+    }
+
+    lock_acquire(&swap_lock);
+    for (i = 0; i < req->cnt; i++) {
+      struct swap_cache_entry *e = swap_cache_find(req->slots[i]);
+
+      ASSERT(e != NULL && e->frame == NULL);
+      if (i < cnt) {
+        e->frame = frames[i];
+        ra_read_cnt++;
+      } else {
+        slot_release(e->slot);
+        *e = (struct swap_cache_entry){.slot = BITMAP_ERROR};
+      }
+    }
+    cond_broadcast(&swap_cache_cond, &swap_lock);
+    lock_release(&swap_lock);
+    free(req);
+  }
+}
+
+/* Prints swap statistics. Free slots outside free clusters are
+ * fragmented: no run can be clustered there. */
+void swap_print_stats(void) {
+  size_t free_slots = cluster_cnt * SWAP_CLUSTER - used_slots;
+  size_t free_cnt = 0, fragmented;
+
+  for (size_t i = 0; i < swap_dev_cnt; i++) {
+    struct swap_dev *d = &swap_devs[i];
+    size_t used = 0;
+
+    for (size_t c = d->first; c < d->first + d->cnt; c++) used += clusters[c].used;
+    printf("Swap: hd%d:%d, priority %d: %zu of %zu slots used\n", d->chan_no, d->dev_no, d->prio,
+           used, d->cnt * SWAP_CLUSTER);
+    free_cnt += d->free.cnt;
+  }
+  fragmented = free_slots - free_cnt * SWAP_CLUSTER;
+  printf("Swap: %zu of %zu slots used, %zu at peak\n", used_slots, cluster_cnt * SWAP_CLUSTER,
+         peak_slots);
+  printf("Swap: %zu clusters free, %zu partly used, %zu%% of free slots fragmented\n", free_cnt,
+         partial_clusters.cnt, free_slots > 0 ? fragmented * 100 / free_slots : 0);
+  printf("Swap: %lld slots in clusters, %lld elsewhere\n", clustered_cnt, scattered_cnt);
+  printf("Swap read-ahead: %lld pages read, %lld hit, %lld wasted\n", ra_read_cnt, ra_hit_cnt,
+         ra_wasted_cnt);
 }
@@ -0,0 +1,45 @@
+/* clock.c: Second-chance clock replacement.
+ *
+ * The hand sweeps the frame table in order and evicts the first frame
+ * whose accessed bits are clear, clearing them on the way. */
+
+#include "vm/policy.h"
+#include "vm/vm.h"
+
+static struct frame *frames;
+static size_t frame_cnt;
+static size_t hand; /* Index of the frame last looked at. */
+
+static void clock_init(struct frame *table, size_t cnt) {
+  frames = table;
+  frame_cnt = cnt;
+  hand = cnt - 1;
+}
+
+static void clock_insert(struct frame *frame UNUSED, size_t dist UNUSED) {}
+
+static void clock_access(struct frame *frame UNUSED) {}
+
+/* Gives up after two full sweeps, when every frame stayed busy. */
+static struct frame *clock_victim(void) {
+  for (size_t budget = 2 * frame_cnt; budget > 0; budget--) {
+    if (++hand == frame_cnt) hand = 0;
+
+    struct frame *frame = &frames[hand];
+    if (!vm_frame_evictable(frame)) continue;
+    if (vm_frame_referenced(frame)) continue;  // second-chance
+    return frame;
+  }
+  return NULL;
+}
+
+static void clock_remove(struct frame *frame UNUSED) {}
+
+const struct vm_policy vm_policy_clock = {
+    .name = "clock",
+    .init = clock_init,
+    .insert = clock_insert,
+    .access = clock_access,
+    .victim = clock_victim,
+    .remove = clock_remove,
+};
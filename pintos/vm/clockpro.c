@@ -0,0 +1,130 @@
+/* clockpro.c: CLOCK-Pro replacement (Jiang, Chen and Zhang, USENIX 2005).
+ *
+ * Resident pages are either hot or cold, and only cold pages are evicted.
+ * A new cold page starts a test period. If it is referenced again during
+ * that period, it becomes hot. HAND_COLD looks for victims among the cold
+ * pages. HAND_HOT turns unreferenced hot pages cold whenever the hot pages
+ * outgrow their share, and ends the test periods of the cold pages it passes.
+ *
+ * Non-resident cold pages are not kept on the clock. A page that refaults
+ * within as many evictions as there are frames counts as reused during its
+ * test period. Every such reuse grows the cold share; every test period
+ * that ends without one shrinks it. */
+
+#include "threads/malloc.h"
+#include "vm/policy.h"
+#include "vm/vm.h"
+
+/* Per-frame state, indexed like the frame table. */
+struct clockpro_frame {
+  bool queued; /* Holds a page known to the policy. */
+  bool hot;
+  bool test;   /* Cold page in its test period. */
+};
+
+static struct frame *frames;
+static struct clockpro_frame *meta;
+static size_t frame_cnt;
+static size_t hand_cold, hand_hot;
+static size_t hot_cnt;
+static size_t cold_target, cold_min; /* Adaptive number of cold frames. */
+
+static void clockpro_init(struct frame *table, size_t cnt) {
+  frames = table;
+  frame_cnt = cnt;
+  meta = calloc(cnt, sizeof *meta);
+  if (meta == NULL) PANIC("clockpro_init: out of memory");
+  hand_cold = hand_hot = cnt - 1;
+  cold_min = cnt / 64 > 0 ? cnt / 64 : 1;
+  cold_target = cnt / 8 > cold_min ? cnt / 8 : cold_min;
+}
+
+static void cold_grow(void) {
+  if (cold_target + 1 < frame_cnt) cold_target++;
+}
+
+static void cold_shrink(void) {
+  if (cold_target > cold_min) cold_target--;
+}
+
+static void make_hot(struct clockpro_frame *m) {
+  m->hot = true;
+  m->test = false;
+  hot_cnt++;
+}
+
+/* Advances HAND_HOT until it has turned one hot page cold. */
+static void run_hand_hot(void) {
+  for (size_t budget = 2 * frame_cnt; budget > 0; budget--) {
+    if (++hand_hot == frame_cnt) hand_hot = 0;
+
+    struct frame *frame = &frames[hand_hot];
+    struct clockpro_frame *m = &meta[hand_hot];
+    if (!m->queued || frame->pinned) continue;
+    if (!m->hot) {
+      if (m->test) {  // 재참조 없이 시험 기간 종료
+        m->test = false;
+        cold_shrink();
+      }
+      continue;
+    }
+    if (vm_frame_referenced(frame)) continue;
+    m->hot = false;
+    hot_cnt--;
+    return;
+  }
+}
+
+static void clockpro_insert(struct frame *frame, size_t dist) {
+  struct clockpro_frame *m = &meta[frame - frames];
+
+  m->queued = true;
+  if (dist < frame_cnt) {  // 시험 기간 안에 다시 쓰인 페이지
+    cold_grow();
+    make_hot(m);
+  } else {
+    m->hot = false;
+    m->test = true;
+  }
+}
+
+static void clockpro_access(struct frame *frame UNUSED) {}
+
+static struct frame *clockpro_victim(void) {
+  const size_t sweeps = 4;
+
+  if (hot_cnt + cold_target > frame_cnt) run_hand_hot();
+  for (size_t budget = sweeps * frame_cnt; budget > 0; budget--) {
+    // 한 바퀴 동안 cold 페이지를 못 찾았으면 hot 페이지 하나를 식힘
+    if (budget % frame_cnt == 0 && budget != sweeps * frame_cnt) run_hand_hot();
+    if (++hand_cold == frame_cnt) hand_cold = 0;
+
+    struct frame *frame = &frames[hand_cold];
+    struct clockpro_frame *m = &meta[hand_cold];
+    if (!m->queued || m->hot || !vm_frame_evictable(frame)) continue;
+    if (!vm_frame_referenced(frame)) return frame;
+    if (m->test) {
+      cold_grow();
+      make_hot(m);
+    } else {
+      m->test = true;
+    }
+  }
+  return NULL;
+}
+
+static void clockpro_remove(struct frame *frame) {
+  struct clockpro_frame *m = &meta[frame - frames];
+
+  if (m->hot) hot_cnt--;
+  *m = (struct clockpro_frame){.queued = false};
+}
+
+const struct vm_policy vm_policy_clockpro = {
+    .name = "clockpro",
+    .init = clockpro_init,
+    .insert = clockpro_insert,
+    .access = clockpro_access,
+    .victim = clockpro_victim,
+    .remove = clockpro_remove,
+};
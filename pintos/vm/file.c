@@ -1,16 +1,26 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
+#include <madvise.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "devices/timer.h"
 #include "include/threads/vaddr.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h";
+#include "threads/thread.h"
+#include "userprog/syscall.h"
 #include "vm/vm.h"
 
 static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
 static void file_backed_destroy(struct page *page);
-
-#define MIN(A, B) (A) > (B) ? (B) : (A);
-#define MAX(A, B) (A) > (B) ? (A) : (B);
+static void readahead_thread(void *aux);
+static void writeback_thread(void *aux);
+static void mmap_ra_cancel(struct mmap_ra *ra);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
@@ -20,8 +30,54 @@ static const struct page_operations file_ops = {
     .type = VM_FILE,
 };
 
+/* Read-ahead of mmaps, after Linux's on-demand read-ahead.
+ *
+ * Faults on an mmap form a stream when each lands on the first page not
+ * resident after the previous one (sequential), or twice in a row the
+ * same number of pages further (strided). A stream gets a window of pages
+ * read ahead by the read-ahead thread into free frames, which sit in the
+ * mapping's cache until their page faults; such a fault only installs the
+ * frame. When memory runs low, the page-out daemon and a fault that finds
+ * no free frame take the oldest cached frames before evicting any page. Faulting on the first page of the latest window issues the next
+ * window, twice as large up to readahead_max. A fault the cache misses
+ * halves the window, or ends the stream if the pattern broke. A mapping
+ * advised MADV_SEQUENTIAL always has a sequential stream with the largest
+ * window. */
+
+#define RA_MIN 2
+#define RA_INIT 4
+
+size_t readahead_max = 16;
+
+static struct list ra_queue; /* Windows to read, in order. */
+static struct list ra_cache_lru; /* Frames in the caches, oldest first. */
+static struct lock ra_lock;  /* Protects ra_queue, ra_cache_lru and the caches. */
+static struct semaphore ra_sema; /* Counts the windows in ra_queue. */
+
+/* Writeback. Every WRITEBACK_INTERVAL ticks, the writeback thread writes
+ * dirty mmap pages back to their files, up to WRITEBACK_BATCH at a time in
+ * file offset order, so that neither eviction nor munmap and exit have to
+ * write them all at once. msync() does the same for a range right away,
+ * and munmap and exit for the whole mapping. Dirty pages that follow each
+ * other in a file are written together, up to WRITEBACK_RUN of them with
+ * a single write; clean pages never reach the file system. */
+#define WRITEBACK_INTERVAL TIMER_FREQ
+#define WRITEBACK_BATCH 64
+#define WRITEBACK_RUN 32
+
+/* Statistics. */
+static long long ra_read_cnt, ra_hit_cnt, ra_wasted_cnt;
+static long long wb_cnt, msync_cnt, unmap_wb_cnt, wb_write_cnt;
+
 /* The initializer of file vm */
-void vm_file_init(void) {}
+void vm_file_init(void) {
+  list_init(&ra_queue);
+  list_init(&ra_cache_lru);
+  lock_init(&ra_lock);
+  sema_init(&ra_sema, 0);
+  thread_create("readahead", PRI_DEFAULT, readahead_thread, NULL);
+  thread_create("writeback", PRI_DEFAULT, writeback_thread, NULL);
+}
 
 /* Initialize the file backed page */
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva) {
@@ -29,10 +85,23 @@ bool file_backed_initializer(struct page *page, enum vm_type type, void *kva) {
   page->operations = &file_ops;
 
   struct file_page *file_page = &page->file;
+  file_page->text = (type & VM_TEXT) != 0;
 
   return true;
 }
 
+/* Turns the uninit PAGE into a file page without reading its contents,
+ * for a caller that maps it to a frame holding them already. */
+void file_backed_bind(struct page *page) {
+  struct file_load_aux *aux = page->uninit.aux;
+
+  file_backed_initializer(page, page->uninit.type, NULL);
+  page->file.file = aux->file;
+  page->file.ofs = aux->file_ofs;
+  page->file.read_bytes = aux->read_bytes;
+  free(aux);
+}
+
 /* Swap in the page by read contents from the file. */
 static bool file_backed_swap_in(struct page *page, void *kva) {
   struct file_page *fp UNUSED = &page->file;
@@ -40,6 +109,7 @@ static bool file_backed_swap_in(struct page *page, void *kva) {
   if (file_read_at(fp->file, page->frame->kva, fp->read_bytes, fp->ofs) != (int)fp->read_bytes) {
     return false;
   }
+  vm_stat_inc(page->spt, file_reads);
   memset(page->frame->kva + fp->read_bytes, 0, PGSIZE - fp->read_bytes);
 
   // hex_dump((intptr_t)page->frame->kva, page->frame->kva, aux->read_bytes, true);
@@ -51,45 +121,133 @@ static bool file_backed_swap_out(struct page *page) {
   struct file_page *file_page UNUSED = &page->file;
 
   // memory to file
-  if (pml4_is_dirty(page->pml4, page->va)) {
-    return set_dirty_to_file(page->pml4, page);
+  if (pml4_is_dirty(page_pml4(page), page->va)) {
+    return set_dirty_to_file(page_pml4(page), page);
   }
 
   return true;
 }
 
+/* Writes P back to its file. The dirty bit is cleared first, so that a
+ * write to P while it is being written back dirties it again. */
 bool set_dirty_to_file(uint64_t *pml4, struct page *p) {
   struct file_page *fp UNUSED = &p->file;
 
+  pml4_set_dirty(pml4, p->va, false);
   if ((file_write_at(fp->file, p->frame->kva, fp->read_bytes, fp->ofs)) != fp->read_bytes) {
+    pml4_set_dirty(pml4, p->va, true);
     return false;
   }
-  pml4_set_dirty(pml4, p->va, false);
+  vm_stat_inc(p->spt, writebacks);
 
   return true;
 }
 
-/* Destory the file backed page. PAGE will be freed by the caller. */
-static void file_backed_destroy(struct page *page) {
-  struct file_page *file_page UNUSED = &page->file;
+/* Returns true if the file page B comes right after the whole page A in
+ * the same file. */
+static bool page_follows(const struct page *a, const struct page *b) {
+  return file_get_inode(a->file.file) == file_get_inode(b->file.file) &&
+         a->file.read_bytes == PGSIZE && b->file.ofs == a->file.ofs + PGSIZE;
+}
 
-  struct thread *t = thread_current();
-  struct pml4 *pml4 = t->pml4;
+/* Writes the CNT pinned pages of RUN, each following the one before in
+ * their file, back with a single write. Dirty bits are cleared first, as
+ * in set_dirty_to_file(). The write holds filesys_lock, as the syscalls
+ * do; the pages are pinned, so it never faults while holding it. */
+static bool writeback_run(struct page *run[], size_t cnt) {
+  const void *kvas[WRITEBACK_RUN];
+  off_t size = 0;
+  off_t written;
+
+  for (size_t i = 0; i < cnt; i++) {
+    pml4_set_dirty(page_pml4(run[i]), run[i]->va, false);
+    kvas[i] = run[i]->frame->kva;
+    size += run[i]->file.read_bytes;
+  }
+  lock_acquire(&filesys_lock);
+  written = file_write_pages_at(run[0]->file.file, kvas, cnt, size, run[0]->file.ofs);
+  lock_release(&filesys_lock);
+  if (written != size) {
+    for (size_t i = 0; i < cnt; i++) pml4_set_dirty(page_pml4(run[i]), run[i]->va, true);
+    return false;
+  }
+  for (size_t i = 0; i < cnt; i++) vm_stat_inc(run[i]->spt, writebacks);
+  wb_write_cnt++;
+  return true;
+}
+
+/* Writes back the dirty ones of the CNT pinned file pages of PAGES, sorted
+ * by file and offset, and unpins them. Adds the number of pages written
+ * to *WRITTEN. Returns false if a write failed. */
+static bool writeback_pages(struct page *pages[], size_t cnt, long long *written) {
+  bool succ = true;
+
+  for (size_t i = 0, j; i < cnt; i = j) {
+    j = i + 1;
+    if (!pml4_is_dirty(page_pml4(pages[i]), pages[i]->va)) continue;
+    while (j < cnt && j - i < WRITEBACK_RUN && page_follows(pages[j - 1], pages[j]) &&
+           pml4_is_dirty(page_pml4(pages[j]), pages[j]->va))
+      j++;
+    if (writeback_run(&pages[i], j - i))
+      *written += j - i;
+    else
+      succ = false;
+  }
+  for (size_t i = 0; i < cnt; i++) vm_unpin_frame(pages[i]->frame);
+  return succ;
+}
 
-  if (pml4_get_page(pml4, page->va) && pml4_is_dirty(pml4, page->va)) {
-    set_dirty_to_file(pml4, page);
+/* Writes the dirty resident file pages of SPT from START to END back. The
+ * pages of a mapping are in file offset order already, by address. */
+static bool writeback_range(struct supplemental_page_table *spt, uint8_t *start, uint8_t *end,
+                            long long *written) {
+  struct page *pages[WRITEBACK_BATCH];
+  size_t cnt = 0;
+  bool succ = true;
+
+  for (uint8_t *va = start; va < end; va += PGSIZE) {
+    struct page *p = spt_lookup_page(spt, va);
+
+    // 로드되지 않았거나 내보내졌거나 깨끗한 페이지는 건너뜀
+    if (p == NULL || VM_TYPE(p->operations->type) != VM_FILE ||
+        !pml4_is_dirty(page_pml4(p), p->va) || vm_pin_page(p) == NULL)
+      continue;
+    pages[cnt++] = p;
+    if (cnt == WRITEBACK_BATCH) {
+      succ = writeback_pages(pages, cnt, written) && succ;
+      cnt = 0;
+    }
   }
+  return writeback_pages(pages, cnt, written) && succ;
+}
+
+/* Destory the file backed page. PAGE will be freed by the caller.
+ * Whoever destroys dirty mmap pages writes them back first, in runs, with
+ * writeback_range(): munmap, exit and MADV_DONTNEED. */
+static void file_backed_destroy(struct page *page UNUSED) {}
+
+/* Fills the page at KVA as described by AUX, from the contents fault-around
+ * or read-ahead already read if there are. */
+bool file_load_contents(struct file_load_aux *aux, void *kva) {
+  if (aux->prefetch == kva)
+    ;  // read-ahead frame, already filled
+  else if (aux->prefetch != NULL)
+    memcpy(kva, aux->prefetch, aux->read_bytes);
+  else if (file_read_at(aux->file, kva, aux->read_bytes, aux->file_ofs) != (int)aux->read_bytes)
+    return false;
+  else
+    vm_stat_inc(&thread_current()->spt, file_reads);
+  memset(kva + aux->read_bytes, 0, PGSIZE - aux->read_bytes);
+  return true;
 }
 
-static bool lazy_load_file(struct page *page, void *_aux) {
+bool lazy_load_file(struct page *page, void *_aux) {
   struct file_load_aux *aux = _aux;
 
-  if (file_read_at(aux->file, page->frame->kva, aux->read_bytes, aux->file_ofs) !=
-      (int)aux->read_bytes) {
+  if (!file_load_contents(aux, page->frame->kva)) {
     free(aux);
     return false;
   }
-  memset(page->frame->kva + aux->read_bytes, 0, aux->zero_bytes);
 
   page->file.file = aux->file;
   page->file.ofs = aux->file_ofs;
@@ -101,90 +259,434 @@ static bool lazy_load_file(struct page *page, void *_aux) {
   return true;
 }
 
-static void clean_pages(struct list *aux_list) {
-  struct list_elem *cur, *next;
-  for (cur = list_begin(aux_list); cur != list_end(aux_list); cur = next) {
-    next = list_next(cur);
-    struct file_load_aux *aux = list_entry(cur, struct file_load_aux, elem);
-    spt_remove_page(&thread_current()->spt, spt_find_page(&thread_current()->spt, aux->va));
-    free(aux);
-  }
-}
-
-/* Do the mmap */
+/* Do the mmap.
+ * Only the region is set up here: the pages of the mapping are created
+ * as they are first touched. */
 void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset) {
-  struct list aux_list;
-  list_init(&aux_list);
+  struct thread *t = thread_current();
+  struct mmap_desc *desc = malloc(sizeof *desc);
+  struct vma *vma = malloc(sizeof *vma);
   struct file *new_file = file_reopen(file);
-  size_t f_len = file_length(new_file);
-
-  off_t done = 0;
-  while (done < length) {
-    struct file_load_aux *aux = malloc(sizeof *aux);
-    if (aux == NULL) goto fail;
-
-    off_t remain = length - done;
-    size_t page_bytes = MIN(remain, PGSIZE);
-    off_t cur_ofs = offset + done;
-    size_t file_left = MAX(f_len - cur_ofs, 0);
-
-    aux->file = new_file;
-    aux->file_ofs = cur_ofs;
-    aux->read_bytes = MIN(page_bytes, file_left);
-    aux->zero_bytes = PGSIZE - aux->read_bytes;
-    aux->va = addr;
-    list_push_back(&aux_list, &aux->elem);
-
-    if (!vm_alloc_page_with_initializer(VM_FILE, addr + done, writable, lazy_load_file, aux)) {
-      printf("vm_alloc_page_with_initializer failed\n");
-      goto fail;
-    }
+  off_t f_len;
+
+  if (desc == NULL || vma == NULL || new_file == NULL) goto fail;
+  f_len = file_length(new_file);
+  *vma = (struct vma){.start = addr,
+                      .end = (uint8_t *)addr + ROUND_UP(length, PGSIZE),
+                      .type = VM_FILE,
+                      .writable = writable,
+                      .file = new_file,
+                      .ofs = offset,
+                      .read_bytes = length < (size_t)(f_len - offset) ? length : (size_t)(f_len - offset),
+                      .init = lazy_load_file,
+                      .owns_file = true,
+                      .mmap = desc};
+  // 영역이 아닌 페이지(스택 등)와 겹쳐도 실패
+  for (uint8_t *va = vma->start; va < vma->end; va += PGSIZE)
+    if (spt_lookup_page(&t->spt, va) != NULL) goto fail;
+  if (!vma_insert(&t->spt, vma)) goto fail;
 
-    done += PGSIZE;
-  }
-
-  struct mmap_desc *desc = malloc(sizeof *desc);
-  if (desc == NULL) goto fail;
   desc->start = addr;
-  desc->length = pg_round_down(length);
+  desc->length = vma->end - vma->start;
   desc->file = new_file;
+  desc->ofs = offset;
+  desc->writable = writable;
+  desc->vma = vma;
+  desc->ra = (struct mmap_ra){.prev = SIZE_MAX};
+  sema_init(&desc->ra.done, 0);
 
-  list_push_back(&thread_current()->mmaps, &desc->elem);
+  list_push_back(&t->mmaps, &desc->elem);
   return addr;
 
 fail:
-  clean_pages(&aux_list);
+  free(desc);
+  free(vma);
   file_close(new_file);
   return NULL;
 }
 
-static bool find_start_va(const struct list_elem *elem, void *aux) {
-  struct mmap_desc *desc = list_entry(elem, struct mmap_desc, elem);
-  return desc->start == aux;
-}
-
+/* Returns the mmap of T starting at ADDR, or NULL. */
 struct mmap_desc *mmap_lookup(struct thread *t, void *addr) {
-  struct list_elem *elem = list_find(&t->mmaps, find_start_va, addr);
-  return list_entry(elem, struct mmap_desc, elem);
+  struct vma *vma = vma_find(&t->spt, addr);
+  return vma != NULL && vma->start == addr ? vma->mmap : NULL;
 }
 
-/* Do the munmap */
+/* Do the munmap.
+ * Pages of the mapping that were never touched do not exist. */
 void do_munmap(struct mmap_desc *desc) {
   struct thread *t = thread_current();
-  void *va = desc->start;
+  struct vma *vma = desc->vma;
 
-  list_remove(list_find(&t->mmaps, find_start_va, va));
-  off_t done = 0;
-  while (done < desc->length) {
-    struct page *p = spt_find_page(&t->spt, (char *)va + done);
+  mmap_ra_cancel(&desc->ra);
+  vma_remove(&t->spt, vma);
+  writeback_range(&t->spt, vma->start, vma->end, &unmap_wb_cnt);  // dirty write-back
+  spt_remove_range(&t->spt, vma->start, vma->end);  // TLB flush와 프레임 해제를 묶어서
+  vma_destroy(vma);  // 파일과 desc도 함께 해제
+}
 
-    // dirty write-back
-    if (pml4_is_dirty(t->pml4, va)) {
-      set_dirty_to_file(t->pml4, p);
+/* Reads the queued windows, one at a time. */
+static void readahead_thread(void *aux UNUSED) {
+  for (;;) {
+    struct mmap_ra_window *w;
+    struct mmap_ra *ra;
+
+    sema_down(&ra_sema);
+    lock_acquire(&ra_lock);
+    w = list_entry(list_pop_front(&ra_queue), struct mmap_ra_window, elem);
+    lock_release(&ra_lock);
+
+    for (size_t i = 0; i < w->cnt; i++) {
+      struct frame *frame = vm_alloc_frame();
+
+      // 빈 프레임이 없으면 나머지는 읽지 않음
+      if (frame != NULL) {
+        lock_acquire(&filesys_lock);
+        off_t n = file_read_at(w->file, frame->kva, w->bytes[i], w->ofs[i]);
+        lock_release(&filesys_lock);
+        if (n != (off_t)w->bytes[i]) {
+          vm_free_frame(frame);
+          frame = NULL;
+        }
+      }
+      if (frame != NULL) {
+        memset((uint8_t *)frame->kva + w->bytes[i], 0, PGSIZE - w->bytes[i]);
+        ra_read_cnt++;
+      }
+      w->frames[i] = frame;
     }
 
-    spt_remove_page(&t->spt, p);
-    done += PGSIZE;
+    // 마지막 접근: 이 뒤로 매핑이 해제될 수 있음
+    ra = list_entry(&w->elem, struct mmap_ra, window.elem);
+    sema_up(&ra->done);
   }
-  file_close(desc->file);
+}
+
+/* Returns the mmap of the current process that PAGE, a page still to be
+ * loaded, belongs to, or NULL if it is not part of an mmap. */
+static struct mmap_desc *mmap_of(struct page *page) {
+  struct vma *vma;
+
+  if (VM_TYPE(page->uninit.type) != VM_FILE || page->uninit.aux == NULL) return NULL;
+  vma = vma_find(page->spt, page->va);
+  return vma != NULL ? vma->mmap : NULL;
+}
+
+/* Returns the aux of the page at index IDX of DESC if that page is still to
+ * be loaded from the file, or NULL. */
+static struct file_load_aux *mmap_pending_aux(struct mmap_desc *desc, size_t idx) {
+  struct page *p = spt_find_page(&thread_current()->spt, (uint8_t *)desc->start + idx * PGSIZE);
+  struct file_load_aux *aux;
+
+  if (p == NULL || p->frame != NULL || VM_TYPE(p->operations->type) != VM_UNINIT) return NULL;
+  aux = p->uninit.aux;
+  if (aux == NULL || aux->file != desc->file || aux->read_bytes == 0) return NULL;
+  return aux;
+}
+
+/* Returns the slot of RA caching the page at index IDX, or NULL. Must be
+ * called with ra_lock held. */
+static struct mmap_ra_page *ra_cache_find(struct mmap_ra *ra, size_t idx) {
+  for (size_t i = 0; i < 2 * RA_MAX; i++)
+    if (ra->cache[i].frame != NULL && ra->cache[i].idx == idx) return &ra->cache[i];
+  return NULL;
+}
+
+/* Returns true if RA caches the page at index IDX. */
+static bool ra_cached(struct mmap_ra *ra, size_t idx) {
+  bool found;
+
+  lock_acquire(&ra_lock);
+  found = ra_cache_find(ra, idx) != NULL;
+  lock_release(&ra_lock);
+  return found;
+}
+
+/* Takes the frame of the page at index IDX out of the cache of RA. Returns
+ * NULL if it is not cached. */
+static struct frame *ra_cache_take(struct mmap_ra *ra, size_t idx) {
+  struct mmap_ra_page *c;
+  struct frame *frame = NULL;
+
+  lock_acquire(&ra_lock);
+  if ((c = ra_cache_find(ra, idx)) != NULL) {
+    frame = c->frame;
+    list_remove(&c->elem);
+    c->frame = NULL;
+  }
+  lock_release(&ra_lock);
+  return frame;
+}
+
+/* Frees the read-ahead frame in slot C. Must be called with ra_lock
+ * held. */
+static void ra_cache_evict(struct mmap_ra_page *c) {
+  list_remove(&c->elem);
+  vm_free_frame(c->frame);
+  c->frame = NULL;
+  ra_wasted_cnt++;
+}
+
+/* Caches FRAME, holding the page at index IDX, in RA, in place of the
+ * oldest slot if all are taken. Must be called with ra_lock held. */
+static void ra_cache_put(struct mmap_ra *ra, size_t idx, struct frame *frame) {
+  struct mmap_ra_page *c = NULL;
+
+  for (size_t i = 0; i < 2 * RA_MAX && c == NULL; i++)
+    if (ra->cache[i].frame == NULL) c = &ra->cache[i];
+  if (c == NULL) {
+    c = &ra->cache[ra->hand];
+    ra->hand = (ra->hand + 1) % (2 * RA_MAX);
+    ra_cache_evict(c);
+  }
+  *c = (struct mmap_ra_page){.idx = idx, .frame = frame};
+  list_push_back(&ra_cache_lru, &c->elem);
+}
+
+/* Takes the oldest frame read ahead into any mmap's cache, for a caller
+ * short of memory. Returns it pinned and without pages, or NULL if no
+ * frame is cached. */
+struct frame *mmap_ra_reclaim(void) {
+  struct mmap_ra_page *c;
+  struct frame *frame = NULL;
+
+  lock_acquire(&ra_lock);
+  if (!list_empty(&ra_cache_lru)) {
+    c = list_entry(list_pop_front(&ra_cache_lru), struct mmap_ra_page, elem);
+    frame = c->frame;
+    c->frame = NULL;
+    ra_wasted_cnt++;
+  }
+  lock_release(&ra_lock);
+  return frame;
+}
+
+/* Returns true if the window of RA is still being read. Only the mapping
+ * process reads and writes BUSY. The read-ahead thread just ups DONE, as
+ * its last access to RA, so RA may be freed once DONE has been downed. */
+static bool ra_busy(struct mmap_ra *ra) {
+  if (ra->busy && sema_try_down(&ra->done)) ra->busy = false;
+  return ra->busy;
+}
+
+/* Waits until the window of RA, if any, has been read. */
+static void ra_wait(struct mmap_ra *ra) {
+  if (!ra->busy) return;
+  sema_down(&ra->done);
+  ra->busy = false;
+}
+
+/* Moves the frames of the finished window into the cache. */
+static void ra_collect(struct mmap_ra *ra) {
+  struct mmap_ra_window *w = &ra->window;
+
+  if (ra_busy(ra)) return;
+  lock_acquire(&ra_lock);
+  for (size_t i = 0; i < w->cnt; i++)
+    if (w->frames[i] != NULL) ra_cache_put(ra, w->first + i * w->step, w->frames[i]);
+  lock_release(&ra_lock);
+  w->cnt = 0;
+}
+
+/* Frees every cached frame of RA. */
+static void ra_drop(struct mmap_ra *ra) {
+  lock_acquire(&ra_lock);
+  for (size_t i = 0; i < 2 * RA_MAX; i++)
+    if (ra->cache[i].frame != NULL) ra_cache_evict(&ra->cache[i]);
+  lock_release(&ra_lock);
+}
+
+/* Queues the window of up to RA->size pages of DESC from FIRST on, every
+ * RA->step pages. The window ends before the first page that is loaded
+ * already. Does nothing while the previous window is still being read. */
+static void ra_issue(struct mmap_desc *desc, size_t first) {
+  struct mmap_ra *ra = &desc->ra;
+  struct mmap_ra_window *w = &ra->window;
+  size_t cnt = 0;
+
+  if (ra_busy(ra)) return;
+  ra_collect(ra);
+  for (; cnt < ra->size; cnt++) {
+    size_t idx = first + cnt * ra->step;
+    struct file_load_aux *aux = mmap_pending_aux(desc, idx);
+
+    if (aux == NULL || ra_cached(ra, idx)) break;
+    w->ofs[cnt] = aux->file_ofs;
+    w->bytes[cnt] = aux->read_bytes;
+  }
+  ra->marker = first;
+  ra->next = first + cnt * ra->step;
+  if (cnt == 0) return;
+
+  w->file = desc->file;
+  w->first = first;
+  w->step = ra->step;
+  w->cnt = cnt;
+  ra->busy = true;
+  sema_init(&ra->done, 0);
+  lock_acquire(&ra_lock);
+  list_push_back(&ra_queue, &w->elem);
+  lock_release(&ra_lock);
+  sema_up(&ra_sema);
+}
+
+/* Called on a fault on PAGE, a page still to be loaded from a file.
+ * If PAGE belongs to an mmap, updates its stream and returns the frame PAGE
+ * was read ahead into, or NULL. The frame is pinned and without pages, and
+ * loading PAGE into it reads nothing. Sets *STREAM if the mmap has a stream,
+ * which then reads PAGE's neighbours ahead of use. */
+struct frame *mmap_readahead(struct page *page, bool *stream) {
+  struct mmap_desc *desc = mmap_of(page);
+  struct mmap_ra *ra;
+  struct frame *frame = NULL;
+  size_t max = readahead_max < RA_MAX ? readahead_max : RA_MAX;
+  size_t idx, i;
+  bool advised;
+
+  *stream = false;
+  if (desc == NULL || max < RA_MIN) return NULL;
+  ra = &desc->ra;
+  advised = desc->vma->advice == MADV_SEQUENTIAL;
+  idx = ((uint8_t *)page->va - (uint8_t *)desc->start) / PGSIZE;
+
+  // 읽는 중인 창의 페이지면 읽기가 끝날 때까지 기다림
+  if (ra_busy(ra) && idx >= ra->window.first && (idx - ra->window.first) % ra->window.step == 0 &&
+      (idx - ra->window.first) / ra->window.step < ra->window.cnt)
+    ra_wait(ra);
+  ra_collect(ra);
+
+  if ((frame = ra_cache_take(ra, idx)) != NULL) {
+    ra_hit_cnt++;
+    ((struct file_load_aux *)page->uninit.aux)->prefetch = frame->kva;
+    if (idx == ra->marker) {
+      ra->size = ra->size * 2 < max && !advised ? ra->size * 2 : max;
+      ra_issue(desc, ra->next);
+    }
+  } else {
+    bool sequential = ra->prev != SIZE_MAX && idx > ra->prev;
+
+    // 사이의 페이지가 모두 올라와 있으면 순차 접근 (fault-around 포함)
+    for (i = ra->prev + 1; sequential && i < idx; i++)
+      if (mmap_pending_aux(desc, i) != NULL) sequential = false;
+    ra_drop(ra);
+    if (advised) {
+      ra->size = max;
+      ra->step = 1;
+      ra_issue(desc, idx + 1);
+    } else if (sequential ||
+               (ra->prev != SIZE_MAX && idx > ra->prev && idx - ra->prev == ra->stride)) {
+      if (ra->step == 0)
+        ra->size = RA_INIT < max ? RA_INIT : max;
+      else
+        ra->size = ra->size / 2 > RA_MIN ? ra->size / 2 : RA_MIN;
+      ra->step = sequential ? 1 : ra->stride;
+      ra_issue(desc, idx + ra->step);
+    } else {
+      ra->step = 0;
+    }
+    ra->stride = ra->prev != SIZE_MAX && idx > ra->prev ? idx - ra->prev : 0;
+  }
+  ra->prev = idx;
+  *stream = ra->step != 0;
+  return frame;
+}
+
+/* Waits for the window of RA being read and frees every frame read ahead. */
+static void mmap_ra_cancel(struct mmap_ra *ra) {
+  ra_wait(ra);
+  ra_collect(ra);
+  ra_drop(ra);
+}
+
+/* Starts reading the pages of DESC from START to END that are still to be
+ * loaded, as far as one read-ahead window reaches. Their faults only
+ * install the frames, and continue the window as a sequential stream. */
+void mmap_willneed(struct mmap_desc *desc, void *start, void *end) {
+  struct mmap_ra *ra = &desc->ra;
+  size_t max = readahead_max < RA_MAX ? readahead_max : RA_MAX;
+  size_t first = ((uint8_t *)start - (uint8_t *)desc->start) / PGSIZE;
+  size_t last = ((uint8_t *)end - (uint8_t *)desc->start) / PGSIZE;
+
+  if (max < RA_MIN) return;
+  ra_wait(ra);
+  ra_collect(ra);
+  while (first < last &&
+         (mmap_pending_aux(desc, first) == NULL || ra_cached(ra, first)))
+    first++;
+  if (first == last) return;
+
+  ra->size = last - first < max ? last - first : max;
+  ra->step = 1;
+  ra_issue(desc, first);
+}
+
+/* Stops the read-ahead of every mmap of T, which is exiting. */
+void mmap_readahead_stop(struct thread *t) {
+  for (struct list_elem *e = list_begin(&t->mmaps); e != list_end(&t->mmaps); e = list_next(e))
+    mmap_ra_cancel(&list_entry(e, struct mmap_desc, elem)->ra);
+}
+
+/* Writes the dirty pages of every mmap of the current process back, before
+ * they are destroyed on exit in no particular order. */
+void mmap_writeback_all(void) {
+  struct thread *t = thread_current();
+
+  for (struct list_elem *e = list_begin(&t->mmaps); e != list_end(&t->mmaps); e = list_next(e)) {
+    struct vma *vma = list_entry(e, struct mmap_desc, elem)->vma;
+    writeback_range(&t->spt, vma->start, vma->end, &unmap_wb_cnt);
+  }
+}
+
+/* Writes the dirty mmap pages of the current process from START to END
+ * back, before they are discarded. */
+void mmap_writeback_range(void *start, void *end) {
+  writeback_range(&thread_current()->spt, start, end, &unmap_wb_cnt);
+}
+
+/* Orders pages by file, then by offset in the file. */
+static int page_ofs_cmp(const void *a_, const void *b_) {
+  const struct page *a = *(struct page *const *)a_;
+  const struct page *b = *(struct page *const *)b_;
+  struct inode *ia = file_get_inode(a->file.file), *ib = file_get_inode(b->file.file);
+
+  if (ia != ib) return ia < ib ? -1 : 1;
+  return a->file.ofs < b->file.ofs ? -1 : a->file.ofs > b->file.ofs;
+}
+
+/* Writes dirty mmap pages back in the background. */
+static void writeback_thread(void *aux UNUSED) {
+  struct page *pages[WRITEBACK_BATCH];
+  size_t cnt = 0;
+
+  for (;;) {
+    if (cnt < WRITEBACK_BATCH) timer_sleep(WRITEBACK_INTERVAL);
+
+    cnt = vm_pin_dirty_file_pages(pages, WRITEBACK_BATCH);
+    qsort(pages, cnt, sizeof *pages, page_ofs_cmp);
+    writeback_pages(pages, cnt, &wb_cnt);
+  }
+}
+
+/* Writes the dirty pages of the current process's mmaps in the LENGTH
+ * bytes from ADDR back to their files. Returns false if the range is not
+ * mapped from files entirely, or a write fails. */
+bool do_msync(void *addr, size_t length) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  uint8_t *start = pg_round_down(addr), *end = (uint8_t *)addr + length;
+
+  for (uint8_t *va = start; va < end; va += PGSIZE) {
+    struct page *p = spt_lookup_page(spt, va);
+    struct vma *vma;
+
+    if (p != NULL ? page_get_type(p) != VM_FILE
+                  : (vma = vma_find(spt, va)) == NULL || VM_TYPE(vma->type) != VM_FILE)
+      return false;
+  }
+  return writeback_range(spt, start, end, &msync_cnt);
+}
+
+void vm_file_print_stats(void) {
+  printf("Read-ahead: %lld pages read, %lld hit, %lld wasted\n", ra_read_cnt, ra_hit_cnt,
+         ra_wasted_cnt);
+  printf("Writeback: %lld pages in the background, %lld by msync, %lld on unmap, in %lld writes\n",
+         wb_cnt, msync_cnt, unmap_wb_cnt, wb_write_cnt);
 }
@@ -0,0 +1,39 @@
+/* policy.c: Selection and statistics of the page-replacement policy. */
+
+#include "vm/policy.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const struct vm_policy *const policies[] = {
+    &vm_policy_clock,
+    &vm_policy_2q,
+    &vm_policy_clockpro,
+};
+
+const struct vm_policy *vm_policy = &vm_policy_clock;
+struct vm_policy_stats vm_policy_stats;
+
+/* Makes the policy called NAME the one in use. Must be called before
+ * vm_init(). Returns false if there is no such policy. */
+bool vm_policy_select(const char *name) {
+  for (size_t i = 0; i < sizeof policies / sizeof *policies; i++)
+    if (!strcmp(policies[i]->name, name)) {
+      vm_policy = policies[i];
+      return true;
+    }
+  return false;
+}
+
+/* Prints replacement statistics. The hit rate counts the references seen
+ * in the accessed bits against the faults on pages evicted too early. */
+void vm_policy_print_stats(void) {
+  struct vm_policy_stats *s = &vm_policy_stats;
+  long long refs = s->hits + s->refaults;
+
+  printf("Replacement (%s): %lld faults, %lld refaults, %lld evictions (%lld local), %lld hits\n",
+         vm_policy->name, s->faults, s->refaults, s->evictions, s->local, s->hits);
+  if (refs > 0) printf("Replacement (%s): %lld%% hit rate\n", vm_policy->name, s->hits * 100 / refs);
+  printf("Fault-around: %lld pages\n", s->around);
+  printf("Text sharing: %lld pages\n", s->text);
+}
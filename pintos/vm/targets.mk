@@ -2,4 +2,10 @@ vm_SRC = vm/vm.c          # Main api proxy
 vm_SRC += vm/uninit.c     # Uninitialized page
 vm_SRC += vm/anon.c       # Anonymous page
 vm_SRC += vm/file.c       # File mapped page
+vm_SRC += vm/vma.c        # Address space regions
+vm_SRC += vm/zswap.c      # Compressed swap cache
+vm_SRC += vm/policy.c     # Page replacement policy selection
+vm_SRC += vm/clock.c      # Second-chance clock policy
+vm_SRC += vm/twoq.c       # 2Q policy
+vm_SRC += vm/clockpro.c   # CLOCK-Pro policy
 vm_SRC += vm/inspect.c    # Testing utility
@@ -0,0 +1,119 @@
+/* twoq.c: 2Q replacement (Johnson and Shasha, VLDB 1994).
+ *
+ * New pages enter A1in, a FIFO holding about a quarter of the frames.
+ * A page seen referenced twice while in A1in (LRU-2 style) moves to Am,
+ * the hot queue, which is kept in approximate LRU order by giving its
+ * referenced frames a second chance. Pages touched only once, such as a
+ * sequential scan, leave through A1in without disturbing Am.
+ *
+ * A1out, the queue of recently evicted pages, is not kept explicitly: a
+ * page refaulting within KOUT evictions of its own eviction would still
+ * have been on it, and goes straight to Am. */
+
+#include "threads/malloc.h"
+#include "vm/policy.h"
+#include "vm/vm.h"
+
+enum twoq_queue { Q_NONE, Q_A1IN, Q_AM };
+
+/* Per-frame state, indexed like the frame table. */
+struct twoq_frame {
+  struct list_elem elem; /* Element of a1in or am. */
+  uint8_t queue;         /* enum twoq_queue. */
+  bool referenced;       /* Referenced once already while in A1in. */
+};
+
+static struct frame *frames;
+static struct twoq_frame *meta;
+static struct list a1in, am; /* Most recently queued first. */
+static size_t a1in_cnt, am_cnt;
+static size_t kin, kout;
+
+static struct twoq_frame *meta_of(struct frame *frame) { return &meta[frame - frames]; }
+
+static struct frame *frame_of(struct twoq_frame *m) { return &frames[m - meta]; }
+
+static void enqueue(struct frame *frame, enum twoq_queue queue) {
+  struct twoq_frame *m = meta_of(frame);
+
+  m->queue = queue;
+  m->referenced = false;
+  if (queue == Q_A1IN) {
+    list_push_front(&a1in, &m->elem);
+    a1in_cnt++;
+  } else {
+    list_push_front(&am, &m->elem);
+    am_cnt++;
+  }
+}
+
+static void dequeue(struct frame *frame) {
+  struct twoq_frame *m = meta_of(frame);
+
+  if (m->queue == Q_NONE) return;
+  list_remove(&m->elem);
+  if (m->queue == Q_A1IN)
+    a1in_cnt--;
+  else
+    am_cnt--;
+  m->queue = Q_NONE;
+}
+
+static void twoq_init(struct frame *table, size_t cnt) {
+  frames = table;
+  meta = calloc(cnt, sizeof *meta);
+  if (meta == NULL) PANIC("twoq_init: out of memory");
+  list_init(&a1in);
+  list_init(&am);
+  kin = cnt / 4 > 0 ? cnt / 4 : 1;
+  kout = cnt / 2;
+}
+
+static void twoq_insert(struct frame *frame, size_t dist) {
+  enqueue(frame, dist <= kout ? Q_AM : Q_A1IN);
+}
+
+static void twoq_access(struct frame *frame) {
+  struct twoq_frame *m = meta_of(frame);
+
+  if (m->queue != Q_A1IN) return;
+  if (m->referenced) {
+    dequeue(frame);
+    enqueue(frame, Q_AM);
+  } else {
+    m->referenced = true;
+  }
+}
+
+/* Takes victims from the tail of A1in while it is over KIN, from the tail
+ * of Am otherwise. */
+static struct frame *twoq_victim(void) {
+  size_t budget = 2 * (a1in_cnt + am_cnt) + 2;
+
+  while (budget-- > 0 && a1in_cnt + am_cnt > 0) {
+    bool from_a1in = a1in_cnt > kin || am_cnt == 0;
+    struct list *queue = from_a1in ? &a1in : &am;
+    struct twoq_frame *m = list_entry(list_back(queue), struct twoq_frame, elem);
+    struct frame *frame = frame_of(m);
+
+    // 살아남는 프레임은 큐의 앞으로
+    list_remove(&m->elem);
+    list_push_front(queue, &m->elem);
+
+    if (!vm_frame_evictable(frame)) continue;
+    if (!vm_frame_referenced(frame)) return frame;
+    if (from_a1in) twoq_access(frame);
+  }
+  return NULL;
+}
+
+static void twoq_remove(struct frame *frame) { dequeue(frame); }
+
+const struct vm_policy vm_policy_2q = {
+    .name = "2q",
+    .init = twoq_init,
+    .insert = twoq_insert,
+    .access = twoq_access,
+    .victim = twoq_victim,
+    .remove = twoq_remove,
+};
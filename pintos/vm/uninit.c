@@ -10,6 +10,9 @@
 
 #include "vm/uninit.h"
 
+#include <string.h>
+
+#include "threads/vaddr.h"
 #include "vm/vm.h"
 
 static bool uninit_initialize(struct page *page, void *kva);
@@ -56,7 +59,10 @@ static bool uninit_initialize(struct page *page, void *kva) {
     if (aux) free(aux);
     return false;
   }
-  succ = succ && (init ? init(page, aux) : true);  // load data
+  if (init != NULL)
+    succ = init(page, aux);  // load data
+  else
+    memset(kva, 0, PGSIZE);  // 불러올 내용이 없는 페이지: 프레임엔 이전 내용이 남아 있음
 
   return succ;
 }
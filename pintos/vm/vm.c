@@ -2,16 +2,112 @@
 
 #include "vm/vm.h"
 
+#include <madvise.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <round.h>
+
+#include "devices/timer.h"
+#include "filesys/inode.h"
+#include "intrinsic.h"
 #include "include/threads/vaddr.h"
 #include "lib/kernel/hash.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "userprog/process.h"
 #include "vm/inspect.h"
+#include "vm/policy.h"
+
+/* The frame table: one frame per page of the user pool, indexed by the
+ * page number relative to USER_BASE. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static uint8_t *user_base;
+static struct lock frame_lock;        /* Protects frame_table and every frame's page chain. */
+static struct condition frame_cond;   /* Signaled when a frame gets unpinned or released. */
+static void *zero_page;               /* Read-only frame shared by untouched zero-fill pages. */
+static uint32_t evict_clock;          /* Number of evictions so far. */
+
+/* Page-fault-frequency control of the per-process resident targets. A
+ * process refaulting more than PFF_HIGH times in a window of PFF_WINDOW
+ * ticks has its target raised by that many frames; one refaulting less than
+ * PFF_LOW times has it lowered to its sampled working set. First-touch
+ * faults do not count: more memory would not have avoided them, so a
+ * process streaming through memory does not grow its target. */
+#define PFF_WINDOW (TIMER_FREQ / 10)
+#define PFF_HIGH 8
+#define PFF_LOW 2
+#define PFF_MIN_TARGET 16
+static size_t over_cnt;               /* Processes over their target. */
+static bool local_only;               /* Victims must belong to processes over target. */
+
+/* Resident set limits. A process that maps as many frames as its
+ * rss_limit gets the frame for its next fault by evicting one of its own
+ * pages, picked by the replacement policy among its frames only, rather
+ * than from everyone through the global policy. Speculative fills and huge
+ * pages never take it over its limit. */
+size_t vm_rss_limit;
+static struct supplemental_page_table *local_spt; /* Victims must belong to it. */
+
+size_t fault_around_pages = 8;
+
+/* Drop-behind of regions advised MADV_SEQUENTIAL: a fault makes the page
+ * this many pages behind it the first candidate for eviction. */
+#define DROP_BEHIND 8
+
+struct vmstat vm_stat;
+
+/* Background reclaim. The page-out daemon wakes up when fewer than
+ * vm_low_watermark frames are free and evicts pages until
+ * vm_high_watermark frames are, so that a fault usually finds a free frame
+ * instead of waiting for a victim to be written out. 0 picks a default
+ * relative to the size of the user pool. */
+size_t vm_low_watermark, vm_high_watermark;
+static size_t free_cnt;               /* Frames without pages and not pinned. */
+static size_t used_peak;              /* Most frames ever taken from the user pool. */
+static struct semaphore kswapd_sema;  /* Upped to wake the daemon. */
+static bool kswapd_awake;             /* Woken and not done yet. */
+
+static void kswapd(void *aux UNUSED);
+
+/* Pre-zeroed frames. The zeroing thread runs at the lowest priority, so it
+ * only gets the CPU when nothing else wants it, and keeps up to
+ * zero_pool_max frames zeroed while more than vm_high_watermark frames are
+ * free. A fault on a zero-fill page takes one of them instead of zeroing a
+ * frame itself. Under memory pressure the pool is used up before anything
+ * is evicted. */
+size_t zero_pool_max = 64;
+static struct frame **zero_pool; /* Pinned, without pages and zeroed. */
+static size_t zero_pool_cnt;
+static struct semaphore prezero_sema; /* Upped to wake the zeroing thread. */
+static bool prezero_awake;            /* Woken and not done yet. */
+
+static void prezero(void *aux UNUSED);
 
-static struct list frame_table;
-static struct list_elem *clock_hand;
-static struct lock frame_lock;
+/* Huge pages. The first write to a zero-fill page whose whole surrounding
+ * HUGE_PGSIZE-aligned range is made of untouched zero-fill pages of the
+ * same process maps that range with a single huge page, if the user pool
+ * has an aligned run of HUGE_PGCNT free frames. Each page still owns one
+ * frame of the run, so the replacement policy and the rest of the VM see
+ * ordinary pages. The huge mapping is split back into page table entries
+ * as soon as one of its pages has to be mapped differently. */
+bool vm_huge_pages = true;
+
+/* A frame holding a page of an executable's text, i.e. the page at OFS in
+ * INODE. Text pages are read-only, so every process mapping that page maps
+ * this frame, as one more sharer. The entry goes away when the frame is
+ * evicted or its last sharer unmaps it. */
+struct text_frame {
+  struct hash_elem elem; /* Element of text_frames. */
+  struct inode *inode;
+  off_t ofs;
+  struct frame *frame;
+};
+static struct hash text_frames; /* Protected by frame_lock. */
+
+static uint64_t text_hash(const struct hash_elem *e, void *aux UNUSED);
+static bool text_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED);
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -19,9 +115,31 @@ void vm_init(void) {
   vm_anon_init();
   vm_file_init();
 
-  list_init(&frame_table);
+  user_base = palloc_user_pool(&frame_cnt);
+  frame_table = calloc(frame_cnt, sizeof *frame_table);
+  if (frame_table == NULL) PANIC("vm_init: out of memory");
+  for (size_t i = 0; i < frame_cnt; i++) frame_table[i].kva = user_base + i * PGSIZE;
+  free_cnt = frame_cnt;
+  if (vm_low_watermark == 0) vm_low_watermark = frame_cnt / 32 > 2 ? frame_cnt / 32 : 2;
+  if (vm_high_watermark <= vm_low_watermark) vm_high_watermark = 2 * vm_low_watermark;
+  printf("Frame table: %zu frames, %zu bytes per frame, %s replacement\n", frame_cnt,
+         sizeof *frame_table, vm_policy->name);
+  printf("Page metadata: %zu bytes per page, %zu more until loaded from a file\n",
+         sizeof(struct page), sizeof(struct file_load_aux));
+  vm_policy->init(frame_table, frame_cnt);
   lock_init(&frame_lock);
-  clock_hand = list_begin(&frame_table);
+  cond_init(&frame_cond);
+  hash_init(&text_frames, text_hash, text_less, NULL);
+  sema_init(&kswapd_sema, 0);
+  thread_create("kswapd", PRI_DEFAULT, kswapd, NULL);
+  sema_init(&prezero_sema, 0);
+  if (zero_pool_max > 0) {
+    zero_pool = calloc(zero_pool_max, sizeof *zero_pool);
+    if (zero_pool == NULL) PANIC("vm_init: out of memory");
+    prezero_awake = true;
+    thread_create("prezero", PRI_MIN, prezero, NULL);
+  }
+  zero_page = palloc_get_page(PAL_ASSERT | PAL_ZERO);
 #ifdef EFILESYS /* For project 4 */
   pagecache_init();
 #endif
@@ -44,9 +162,10 @@ enum vm_type page_get_type(struct page *page) {
 }
 
 /* Helpers */
-static struct frame *vm_get_victim(void);
+static struct frame *vm_get_victim(struct supplemental_page_table *own);
 static bool vm_do_claim_page(struct page *page);
-static struct frame *vm_evict_frame(void);
+static bool vm_fill_frame(struct page *page, struct frame *frame, bool speculative);
+static struct frame *vm_evict_frame(struct supplemental_page_table *own, bool wait);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -58,12 +177,13 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
   struct supplemental_page_table *spt = &thread_current()->spt;
 
   /* Check wheter the upage is already occupied or not. */
-  if (spt_find_page(spt, upage) == NULL) {
+  if (spt_lookup_page(spt, upage) == NULL) {
     /* TODO: Create the page, fetch the initialier according to the VM type,
      * TODO: and then create "uninit" page struct by calling uninit_new. You
      * TODO: should modify the field after calling the uninit_new. */
 
     struct page *page = malloc(sizeof *page);
+    if (page == NULL) return false;
     /* TODO: Insert the page into the spt. */
     if (VM_TYPE(type) == VM_ANON) {
       uninit_new(page, upage, init, type, aux, anon_initializer);
@@ -73,7 +193,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
       return false;
     }
 
-    page->pml4 = thread_current()->pml4;
+    page->spt = spt;
     page->writable = writable;
     spt_insert_page(spt, page);
 
@@ -84,9 +204,8 @@ err:
   return false;
 }
 
-/* Find VA from spt and return page. On error, return NULL. */
-struct page *spt_find_page(struct supplemental_page_table *spt, void *va) {
-  /* TODO: Fill this function. */
+/* Returns the page of SPT at VA if it has been created, or NULL. */
+struct page *spt_lookup_page(struct supplemental_page_table *spt, void *va) {
   if (!is_user_vaddr(va)) return NULL;
 
   struct page key;
@@ -96,6 +215,42 @@ struct page *spt_find_page(struct supplemental_page_table *spt, void *va) {
   return (he != NULL) ? hash_entry(he, struct page, hash_elem) : NULL;
 }
 
+/* Creates the page at VA of VMA, a region of the current process. */
+static struct page *vma_create_page(struct supplemental_page_table *spt, struct vma *vma,
+                                    void *va) {
+  struct file_load_aux *aux;
+  off_t ofs;
+  size_t read_bytes;
+
+  ASSERT(spt == &thread_current()->spt);
+  vma_page_layout(vma, va, &ofs, &read_bytes);
+  if (read_bytes == 0 && vma->zero_anon) {
+    if (!vm_alloc_page(VM_ANON, va, vma->writable)) return NULL;
+  } else {
+    if ((aux = malloc(sizeof *aux)) == NULL) return NULL;
+    *aux = (struct file_load_aux){.file = vma->file,
+                                  .file_ofs = ofs,
+                                  .read_bytes = read_bytes};
+    if (!vm_alloc_page_with_initializer(vma->type, va, vma->writable, vma->init, aux)) {
+      free(aux);
+      return NULL;
+    }
+  }
+  return spt_lookup_page(spt, va);
+}
+
+/* Find VA from spt and return page. On error, return NULL.
+ * A page of a region that was never looked up before is created now. */
+struct page *spt_find_page(struct supplemental_page_table *spt, void *va) {
+  /* TODO: Fill this function. */
+  struct page *page = spt_lookup_page(spt, va);
+  struct vma *vma;
+
+  if (page != NULL || !is_user_vaddr(va)) return page;
+  vma = vma_find(spt, va);
+  return vma != NULL ? vma_create_page(spt, vma, pg_round_down(va)) : NULL;
+}
+
 /* Insert PAGE into spt with validation. */
 bool spt_insert_page(struct supplemental_page_table *spt UNUSED, struct page *page UNUSED) {
   bool succ = false;
@@ -107,94 +262,653 @@ bool spt_insert_page(struct supplemental_page_table *spt UNUSED, struct page *pa
   return succ;
 }
 
+/* Returns the frame of KVA, a page of the user pool. */
+static struct frame *frame_of(const void *kva) {
+  ASSERT(pg_ofs(kva) == 0);
+  ASSERT((uint8_t *)kva >= user_base && (uint8_t *)kva < user_base + frame_cnt * PGSIZE);
+  return &frame_table[((uint8_t *)kva - user_base) / PGSIZE];
+}
+
+/* Frame helpers. All of them must be called with frame_lock held. */
+
+/* Updates over_cnt after the resident count or target of SPT changed. */
+static void spt_check_over(struct supplemental_page_table *spt) {
+  bool over = spt->resident > spt->target;
+
+  if (over != spt->over) {
+    spt->over = over;
+    if (over)
+      over_cnt++;
+    else
+      over_cnt--;
+  }
+}
+
+/* Maps PAGE onto FRAME as one more sharer. */
+static void frame_attach(struct frame *frame, struct page *page) {
+  frame->zeroed = false;
+  page->frame = frame;
+  page->next_sharer = frame->page;
+  frame->page = page;
+  frame->ref_cnt++;
+  page->spt->resident++;
+  if (page->spt->resident > page->spt->rss_peak) page->spt->rss_peak = page->spt->resident;
+  spt_check_over(page->spt);
+}
+
+/* Unlinks PAGE from the sharers of FRAME. */
+static void frame_detach(struct frame *frame, struct page *page) {
+  struct page **p = &frame->page;
+
+  while (*p != page) {
+    ASSERT(*p != NULL);
+    p = &(*p)->next_sharer;
+  }
+  *p = page->next_sharer;
+  page->next_sharer = NULL;
+  page->frame = NULL;
+  frame->ref_cnt--;
+  page->spt->resident--;
+  spt_check_over(page->spt);
+}
+
+/* Returns the number of resident pages of SPT referenced since the
+ * replacement policy last cleared their accessed bits. The bits are left
+ * alone. Must be called by the owner of SPT. */
+static size_t spt_sample_working_set(struct supplemental_page_table *spt) {
+  struct hash_iterator i;
+  size_t cnt = 0;
+
+  hash_first(&i, &spt->hash_table);
+  while (hash_next(&i)) {
+    struct page *p = hash_entry(hash_cur(&i), struct page, hash_elem);
+    if (p->frame != NULL && pml4_is_accessed(page_pml4(p), p->va)) cnt++;
+  }
+  return cnt;
+}
+
+/* Accounts a fault of the current process that filled a frame. At the end
+ * of each window, samples its working set and adjusts its target. */
+static void spt_note_fault(struct supplemental_page_table *spt, bool refault) {
+  int64_t now = timer_ticks();
+
+  if (refault) spt->window_refaults++;
+  if (now - spt->window_start < PFF_WINDOW) return;
+
+  spt->wss = spt_sample_working_set(spt);
+  if (spt->window_refaults > PFF_HIGH) {
+    spt->target = spt->resident > spt->target ? spt->resident : spt->target;
+    spt->target += spt->window_refaults;
+    if (spt->target > frame_cnt) spt->target = frame_cnt;
+  } else if (spt->window_refaults < PFF_LOW) {
+    spt->target = spt->wss > PFF_MIN_TARGET ? spt->wss : PFF_MIN_TARGET;
+  }
+  spt_check_over(spt);
+  spt->window_start = now;
+  spt->window_refaults = 0;
+}
+
+/* Returns the unused FRAME to the user pool. */
+static void frame_free(struct frame *frame) {
+  ASSERT(frame->ref_cnt == 0);
+
+  vm_policy->remove(frame);
+  frame->pinned = false;
+  palloc_free_page(frame->kva);
+  free_cnt++;
+}
+
+static void kswapd_wake(void) {
+  if (kswapd_awake) return;
+  kswapd_awake = true;
+  sema_up(&kswapd_sema);
+}
+
+static void prezero_wake(void) {
+  if (prezero_awake || zero_pool_max == 0) return;
+  prezero_awake = true;
+  sema_up(&prezero_sema);
+}
+
+/* Takes a frame from the pre-zeroed ones, pinned and without pages, or
+ * returns NULL if there is none. */
+static struct frame *zero_pool_take(void) {
+  struct frame *frame = zero_pool_cnt > 0 ? zero_pool[--zero_pool_cnt] : NULL;
+
+  if (zero_pool_cnt < zero_pool_max / 2) prezero_wake();
+  return frame;
+}
+
+static void frame_unpin(struct frame *frame) {
+  frame->pinned = false;
+  cond_broadcast(&frame_cond, &frame_lock);
+}
+
+/* Waits until the frame of PAGE, if any, is not in use by someone else
+ * (eviction, fork, teardown) and pins it for the caller. */
+static struct frame *page_pin_frame(struct page *page) {
+  while (page->frame != NULL && page->frame->pinned) cond_wait(&frame_cond, &frame_lock);
+  if (page->frame != NULL) page->frame->pinned = true;
+  return page->frame;
+}
+
+/* Returns true if PAGE is, or is to be loaded as, a page of an executable's
+ * text. */
+static bool page_is_text(struct page *page) {
+  switch (VM_TYPE(page->operations->type)) {
+    case VM_UNINIT:
+      return (page->uninit.type & VM_TEXT) != 0;
+    case VM_FILE:
+      return page->file.text;
+    default:
+      return false;
+  }
+}
+
+/* Returns the entry of text_frames for the text PAGE, or NULL. */
+static struct text_frame *text_find(struct page *page) {
+  struct text_frame key;
+  struct hash_elem *e;
+
+  if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+    struct file_load_aux *aux = page->uninit.aux;
+    key.inode = file_get_inode(aux->file);
+    key.ofs = aux->file_ofs;
+  } else {
+    key.inode = file_get_inode(page->file.file);
+    key.ofs = page->file.ofs;
+  }
+  e = hash_find(&text_frames, &key.elem);
+  return e != NULL ? hash_entry(e, struct text_frame, elem) : NULL;
+}
+
+/* Makes FRAME, just filled with the text PAGE, the frame of that page. */
+static void text_insert(struct frame *frame, struct page *page) {
+  struct text_frame *t;
+
+  if (text_find(page) != NULL) return;  // 동시에 읽은 다른 프레임이 이미 등록됨
+  t = malloc(sizeof *t);
+  if (t == NULL) return;
+  t->inode = file_get_inode(page->file.file);
+  t->ofs = page->file.ofs;
+  t->frame = frame;
+  hash_insert(&text_frames, &t->elem);
+}
+
+/* Forgets FRAME as the frame of the text page it holds, if it is one. */
+static void text_forget(struct frame *frame) {
+  struct text_frame *t;
+
+  if (frame->page == NULL || !page_is_text(frame->page)) return;
+  t = text_find(frame->page);
+  if (t == NULL || t->frame != frame) return;
+  hash_delete(&text_frames, &t->elem);
+  free(t);
+}
+
+/* Breaks up the huge page PAGE is part of, if any, so that the mapping of
+ * PAGE can be changed on its own. */
+static void page_split_huge(struct page *page) {
+  if (!pml4_is_huge(page_pml4(page), page->va)) return;
+  if (!pml4_split_huge(page_pml4(page), page->va)) PANIC("page_split_huge: out of memory");
+  vm_stat_inc(page->spt, huge_splits);
+}
+
+/* Unlinks PAGE, unmapped already, from its pinned frame and frees the
+ * frame when PAGE was the last sharer. */
+static void frame_put(struct page *page) {
+  struct frame *frame = page->frame;
+
+  ASSERT(frame->pinned);
+  if (frame->ref_cnt == 1) text_forget(frame);
+  frame_detach(frame, page);
+  if (frame->ref_cnt == 0)
+    frame_free(frame);
+  else
+    frame_unpin(frame);
+}
+
+/* Unmaps PAGE from its pinned frame and frees the frame when PAGE was the
+ * last sharer. */
 static void frame_release(struct page *page) {
-  pml4_clear_page(thread_current()->pml4, page->va);  // pml4 매핑 해제 (by va)
-  palloc_free_page(page->frame->kva);                 // frame의 kva의 page_alloc 해제
-  free(page->frame);                                  // frame 객체 free
-  page->frame = NULL;                                 // frame 포인터 지우기
+  page_split_huge(page);
+  pml4_clear_page(page_pml4(page), page->va);  // pml4 매핑 해제 (by va)
+  frame_put(page);
+}
+
+/* Returns true if PAGE is an untouched anonymous page without contents
+ * to load, i.e. one that reads as zeros until it is first written. */
+static bool page_is_zero_fill(struct page *page) {
+  return VM_TYPE(page->operations->type) == VM_UNINIT &&
+         VM_TYPE(page->uninit.type) == VM_ANON && page->uninit.init == NULL;
+}
+
+/* Returns true if PAGE is mapped to the shared zero frame. */
+static bool page_maps_zero(struct page *page) {
+  return page->frame == NULL && pml4_get_page(page_pml4(page), page->va) == zero_page;
+}
+
+/* Maps the zero-fill PAGE read-only to the shared zero frame. Its first
+ * write faults again and gets PAGE a frame of its own. */
+static bool page_map_zero(struct page *page) {
+  ASSERT(page_is_zero_fill(page));
+  return pml4_set_page(page_pml4(page), page->va, zero_page, false);
+}
+
+/* Releases every resource of PAGE, including PAGE itself. */
+static void page_kill(struct page *page) {
+  // pml4_destroy()가 공유 zero 프레임을 해제하지 않도록 매핑 제거
+  if (page_maps_zero(page)) pml4_clear_page(page_pml4(page), page->va);
+
+  lock_acquire(&frame_lock);
+  page_pin_frame(page);
+  lock_release(&frame_lock);
+
+  destroy(page);  // file write-back needs the frame still mapped
+
+  lock_acquire(&frame_lock);
+  if (page->frame != NULL) frame_release(page);
+  lock_release(&frame_lock);
+  free(page);
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
-  if (page->frame != NULL) {
-    frame_release(page);  // frame release
-  }
   hash_delete(&spt->hash_table, &page->hash_elem);  // spt table hash 에서 제거 - 중요
-  vm_dealloc_page(page);                            // dealloc_page flow
+  page_kill(page);
+}
 
-  return true;
+/* Pages of one process destroyed together. They are unmapped a batch of
+ * KILL_BATCH at a time, see kill_batch_unmap(), with their TLB entries
+ * left in place; kill_batch_flush() then invalidates them all at once, by
+ * reloading CR3 past TLB_BATCH_MAX pages, after which the caller frees
+ * the frames with frame_put() and the pages. */
+#define KILL_BATCH 32
+
+struct kill_batch {
+  struct tlb_batch tlb;
+  struct page *pages[KILL_BATCH]; /* Still in their table. */
+  size_t cnt;
+};
+
+static void kill_batch_init(struct kill_batch *b, struct supplemental_page_table *spt) {
+  struct thread *t = (struct thread *)((uint8_t *)spt - offsetof(struct thread, spt));
+
+  tlb_batch_init(&b->tlb, t->pml4);
+  b->cnt = 0;
 }
 
-static struct frame *clock_next(void) {
-  if (list_end(&frame_table) != clock_hand) {
-    clock_hand = list_next(clock_hand);
-  } else {
-    clock_hand = list_begin(&frame_table);
+/* Destroys the pages of B as page_kill() would, up to freeing their
+ * frames: the swap slots are released under one hold of the swap lock and
+ * the frames are pinned and unmapped under one hold each of the frame
+ * table lock. The frames stay pinned until frame_put(). */
+static void kill_batch_unmap(struct kill_batch *b) {
+  if (b->cnt == 0) return;
+  anon_release_slots(b->pages, b->cnt);
+
+  lock_acquire(&frame_lock);
+  for (size_t i = 0; i < b->cnt; i++) {
+    struct page *page = b->pages[i];
+
+    if (page_maps_zero(page)) pml4_clear_page_batched(&b->tlb, page->va);
+    page_pin_frame(page);
+  }
+  lock_release(&frame_lock);
+
+  for (size_t i = 0; i < b->cnt; i++) destroy(b->pages[i]);  // write-back은 매핑이 남아 있을 때
+
+  lock_acquire(&frame_lock);
+  for (size_t i = 0; i < b->cnt; i++) {
+    struct page *page = b->pages[i];
+
+    if (page->frame == NULL) continue;
+    page_split_huge(page);
+    pml4_clear_page_batched(&b->tlb, page->va);
   }
+  lock_release(&frame_lock);
+  b->cnt = 0;
+}
+
+static void kill_batch_add(struct kill_batch *b, struct page *page) {
+  b->pages[b->cnt++] = page;
+  if (b->cnt == KILL_BATCH) kill_batch_unmap(b);
+}
 
-  struct frame *next = list_entry(clock_hand, struct frame, elem);
-  return next;
+/* Unmaps the pages added last and invalidates the TLB entries of every
+ * page of B. Frames may be freed from then on. */
+static void kill_batch_flush(struct kill_batch *b) {
+  kill_batch_unmap(b);
+  vm_stat.batched_unmaps += b->tlb.cnt;
+  if (b->tlb.cnt > TLB_BATCH_MAX) vm_stat.tlb_flushes++;
+  tlb_batch_flush(&b->tlb);
 }
 
-/* Get the struct frame, that will be evicted. */
-static struct frame *vm_get_victim(void) {
+/* Removes and destroys the pages of SPT from START to END, with a single
+ * TLB flush. */
+void spt_remove_range(struct supplemental_page_table *spt, void *start, void *end) {
+  struct kill_batch b;
+  uint8_t *va;
+
+  kill_batch_init(&b, spt);
+  for (va = start; va < (uint8_t *)end; va += PGSIZE) {
+    struct page *p = spt_lookup_page(spt, va);
+
+    if (p != NULL) kill_batch_add(&b, p);
+  }
+  kill_batch_flush(&b);
+
+  lock_acquire(&frame_lock);
+  for (va = start; va < (uint8_t *)end; va += PGSIZE) {
+    struct page *p = spt_lookup_page(spt, va);
+
+    if (p == NULL) continue;
+    hash_delete(&spt->hash_table, &p->hash_elem);
+    if (p->frame != NULL) frame_put(p);
+    free(p);
+  }
+  lock_release(&frame_lock);
+}
+
+/* Returns true if FRAME holds pages and nobody is using it right now.
+ * While some process is over its target, only frames of such processes
+ * qualify. */
+bool vm_frame_evictable(const struct frame *frame) {
+  if (frame->page == NULL || frame->pinned) return false;
+  if (local_spt == NULL && !local_only) return true;
+  for (struct page *p = frame->page; p != NULL; p = p->next_sharer)
+    if (local_spt != NULL ? p->spt == local_spt : p->spt->over) return true;
+  return false;
+}
+
+/* Tests and clears the accessed bits of every page mapping FRAME. */
+bool vm_frame_referenced(struct frame *frame) {
+  bool accessed = false;
+
+  vm_stat.clock_sweeps++;
+  for (struct page *p = frame->page; p != NULL; p = p->next_sharer) {
+    if (pml4_is_accessed(page_pml4(p), p->va)) {
+      pml4_set_accessed(page_pml4(p), p->va, false);  // 접근 비트 끄기
+      accessed = true;
+    }
+  }
+  if (accessed) vm_policy_stats.hits++;
+  return accessed;
+}
+
+/* Get the struct frame, that will be evicted. Only frames of OWN qualify
+ * unless it is NULL.
+ * Returns the victim pinned, or NULL if the policy found every frame busy.
+ * Must be called with frame_lock held. */
+static struct frame *vm_get_victim(struct supplemental_page_table *own) {
   struct frame *victim = NULL;
-  /* TODO: The policy for eviction is up to you. */
-  while (true) {
-    victim = clock_next();
-    if (victim->pinned) continue;
-
-    void *va = victim->page->va;
-    if (pml4_is_accessed(victim->page->pml4, va)) {
-      pml4_set_accessed(victim->page->pml4, va, false);  // 접근 비트 끄기
-      continue;                                          // second-chance
+
+  if (own != NULL) {
+    local_spt = own;
+    victim = vm_policy->victim();
+    local_spt = NULL;
+  } else {
+    // 목표를 넘긴 프로세스의 프레임부터, 없으면 전역에서
+    if (over_cnt > 0) {
+      local_only = true;
+      victim = vm_policy->victim();
+      local_only = false;
+      if (victim != NULL) vm_policy_stats.local++;
     }
-    return victim;
+    if (victim == NULL) victim = vm_policy->victim();
   }
+  if (victim == NULL) return NULL;
+  ASSERT(vm_frame_evictable(victim));
+  victim->pinned = true;
+  vm_policy->remove(victim);
+  text_forget(victim);
+  return victim;
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
-static struct frame *vm_evict_frame(void) {
+/* Gives the victim FRAME, whose pages could not be written out, back to
+ * its sharers and to the replacement policy. */
+static void vm_unevict_frame(struct frame *frame) {
+  for (struct page *p = frame->page; p != NULL; p = p->next_sharer)
+    pml4_restore_page(page_pml4(p), p->va, frame->kva);
+  if (page_is_text(frame->page)) text_insert(frame, frame->page);
+  vm_policy->insert(frame, VM_NO_REFAULT);
+  frame_unpin(frame);
+}
+
+/* Evict one page, of OWN only if not NULL, and return the corresponding
+ * frame. A victim whose pages cannot be written out, e.g. because swap is
+ * full, is mapped again and the next one is tried.
+ * Return NULL if no victim could be written out, or if WAIT is false and
+ * every frame is busy. */
+static struct frame *vm_evict_frame(struct supplemental_page_table *own, bool wait) {
   /* TODO: swap out the victim and return the evicted frame. */
-  struct frame *victim = vm_get_victim();
+  struct frame *victim;
+  struct page *p;
+  size_t tries = 0;
   bool succ;
 
-  victim->pinned = true;
-  succ = swap_out(victim->page);
-
-  pml4_clear_page(victim->page->pml4, victim->page->va);
-  victim->page->frame = NULL;
-  victim->page = NULL;
+  lock_acquire(&frame_lock);
+  for (;;) {
+    while ((victim = vm_get_victim(own)) == NULL) {
+      lock_release(&frame_lock);
+      if (!wait) return NULL;
+      thread_yield();
+      lock_acquire(&frame_lock);
+    }
+    /* Unmap first so that nobody writes to the frame while it is written
+     * out. The sharers stay attached until it is, so that a fault on one
+     * of them waits for the eviction to finish. */
+    for (p = victim->page; p != NULL; p = p->next_sharer) {
+      page_split_huge(p);
+      pml4_clear_page(page_pml4(p), p->va);
+    }
+    lock_release(&frame_lock);
 
-  ASSERT(victim->page == NULL);
+    /* Sharers are either all anonymous, and then point at the swap slot
+     * written for the first one, or all text, which is read back from the
+     * executable. */
+    succ = swap_out(victim->page);
+    for (p = victim->page->next_sharer; succ && p != NULL; p = p->next_sharer) {
+      ASSERT(page_get_type(p) == page_get_type(victim->page));
+      if (page_get_type(p) == VM_ANON) anon_dup_slot(p, victim->page);
+    }
 
-  if (!succ) return NULL;
+    lock_acquire(&frame_lock);
+    if (succ) break;
+    vm_unevict_frame(victim);
+    if (++tries >= frame_cnt) {  // 내보낼 수 있는 프레임이 없음
+      lock_release(&frame_lock);
+      return NULL;
+    }
+  }
+  evict_clock++;
+  for (p = victim->page; p != NULL; p = p->next_sharer) p->evict_stamp = evict_clock;
+  vm_policy_stats.evictions++;
+  p = victim->page;
+  if (page_get_type(p) == VM_ANON)
+    vm_stat_inc(p->spt, evictions_anon);
+  else if (page_is_text(p))
+    vm_stat_inc(p->spt, evictions_text);
+  else
+    vm_stat_inc(p->spt, evictions_file);
+  while (victim->page != NULL) frame_detach(victim, victim->page);
+  cond_broadcast(&frame_cond, &frame_lock);  // wake up faults waiting for the eviction
+  lock_release(&frame_lock);
   return victim;
 }
 
+/* Returns a free frame, pinned and without pages, or NULL if the user pool
+ * is exhausted. Never evicts. */
+struct frame *vm_alloc_frame(void) {
+  struct frame *frame;
+  void *kaddr = palloc_get_page(PAL_USER);
+
+  if (kaddr == NULL) return NULL;
+  frame = frame_of(kaddr);  // 페이지 번호로 프레임을 찾아 사용
+  lock_acquire(&frame_lock);
+  ASSERT(!frame->pinned && frame->ref_cnt == 0);
+  frame->pinned = true;
+  if (--free_cnt < vm_low_watermark) kswapd_wake();
+  if (frame_cnt - free_cnt > used_peak) used_peak = frame_cnt - free_cnt;
+  lock_release(&frame_lock);
+  return frame;
+}
+
+/* Waits until the frame of PAGE, if any, is not in use by someone else and
+ * pins it. Returns the frame, or NULL if PAGE is not resident. */
+struct frame *vm_pin_page(struct page *page) {
+  struct frame *frame;
+
+  lock_acquire(&frame_lock);
+  frame = page_pin_frame(page);
+  lock_release(&frame_lock);
+  return frame;
+}
+
+void vm_unpin_frame(struct frame *frame) {
+  lock_acquire(&frame_lock);
+  frame_unpin(frame);
+  lock_release(&frame_lock);
+}
+
+/* Brings in the page at VA of the current process, mapped writable if
+ * WRITE, and pins its frame. Returns false if the page may not be
+ * accessed that way. */
+static bool pin_user_page(uint8_t *va, bool write) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+
+  for (;;) {  // 가져온 사이에 다시 내보내졌으면 되풀이
+    struct page *page = spt_find_page(spt, va);
+    struct frame *frame = NULL;
+    bool ok;
+
+    if (page != NULL) {
+      if (write && !page->writable) return false;
+      lock_acquire(&frame_lock);
+      frame = page_pin_frame(page);
+      if (frame != NULL && (!write || pml4_is_writable(page_pml4(page), va))) {
+        lock_release(&frame_lock);
+        return true;
+      }
+      if (frame != NULL) frame_unpin(frame);
+      lock_release(&frame_lock);
+    }
+    if (frame != NULL)  // copy-on-write 프레임은 미리 복사
+      ok = vm_try_handle_fault(NULL, va, false, true, false);
+    else if (page != NULL && page_maps_zero(page))
+      ok = vm_do_claim_page(page);
+    else
+      ok = vm_try_handle_fault(NULL, va, false, write, true);
+    if (!ok) return false;
+  }
+}
+
+/* Brings in every page of the LENGTH bytes from BUFFER of the current
+ * process and pins their frames until vm_unpin_buffer(), so that a
+ * system call can then copy to or from the buffer without faulting, e.g.
+ * while it holds the file system lock. WRITE is for a buffer the kernel
+ * writes to: copy-on-write pages get a frame of their own first. Returns
+ * false, with nothing left pinned, if a page of the buffer may not be
+ * accessed that way. */
+bool vm_pin_buffer(const void *buffer, size_t length, bool write) {
+  uint8_t *start = pg_round_down(buffer), *end = (uint8_t *)buffer + length;
+
+  if (length == 0) return true;
+  for (uint8_t *va = start; va < end; va += PGSIZE)
+    if (!pin_user_page(va, write)) {
+      vm_unpin_buffer(start, va - start);
+      return false;
+    }
+  return true;
+}
+
+/* Unpins the frames of the buffer pinned by vm_pin_buffer(). */
+void vm_unpin_buffer(const void *buffer, size_t length) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  uint8_t *start = pg_round_down(buffer), *end = (uint8_t *)buffer + length;
+
+  if (length == 0) return;
+  lock_acquire(&frame_lock);
+  for (uint8_t *va = start; va < end; va += PGSIZE) frame_unpin(spt_lookup_page(spt, va)->frame);
+  lock_release(&frame_lock);
+}
+
+/* Pins the frames of up to MAX dirty mmap pages and stores the pages in
+ * PAGES. Each call resumes the scan of the frame table where the previous
+ * one stopped. Returns the number of pages found. */
+size_t vm_pin_dirty_file_pages(struct page *pages[], size_t max) {
+  static size_t cursor;
+  size_t cnt = 0;
+
+  lock_acquire(&frame_lock);
+  for (size_t n = 0; n < frame_cnt && cnt < max; n++) {
+    struct frame *frame = &frame_table[cursor];
+    struct page *p = frame->page;
+
+    if (++cursor == frame_cnt) cursor = 0;
+    if (p == NULL || frame->pinned || VM_TYPE(p->operations->type) != VM_FILE || p->file.text)
+      continue;
+    if (!pml4_is_dirty(page_pml4(p), p->va)) continue;
+    frame->pinned = true;
+    pages[cnt++] = p;
+  }
+  lock_release(&frame_lock);
+  return cnt;
+}
+
+/* Returns FRAME, pinned and without pages, to the user pool. */
+void vm_free_frame(struct frame *frame) {
+  lock_acquire(&frame_lock);
+  frame_free(frame);
+  lock_release(&frame_lock);
+}
+
+/* Returns true if SPT maps as many frames as its resident set limit. */
+static bool spt_at_rss_limit(const struct supplemental_page_table *spt) {
+  return spt->rss_limit != 0 && spt->resident >= spt->rss_limit;
+}
+
+/* Evicts a page of SPT if it is at its resident set limit and returns the
+ * frame, pinned and without pages. Returns NULL if SPT is under its limit
+ * or none of its frames can be evicted right now. */
+static struct frame *rss_reclaim(struct supplemental_page_table *spt) {
+  struct frame *frame;
+
+  if (!spt_at_rss_limit(spt) || (frame = vm_evict_frame(spt, false)) == NULL) return NULL;
+  vm_stat_inc(spt, rss_reclaims);
+  return frame;
+}
+
+/* Sets the resident set limit of the current process to LIMIT frames, 0
+ * for none, and evicts its pages until it is within the limit. */
+void vm_set_rss_limit(size_t limit) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  struct frame *frame;
+
+  spt->rss_limit = limit;
+  while (spt->rss_limit != 0 && spt->resident > spt->rss_limit &&
+         (frame = rss_reclaim(spt)) != NULL)
+    vm_free_frame(frame);
+}
+
 /* palloc() and get frame. If there is no available page, evict the page
  * and return it. This always return valid address. That is, if the user pool
  * memory is full, this function evicts the frame to get the available memory
- * space.*/
+ * space. The returned frame is pinned and has no page. */
 
 static struct frame *vm_get_frame(void) {
   struct frame *frame = NULL;
   /* TODO: Fill this function. */
-  int8_t *kaddr = palloc_get_page(PAL_USER);
-  if (kaddr == NULL) {  // palloc 실패 시 evict로 프레임 사용
-    if ((frame = vm_evict_frame()) == NULL) {
-      PANIC("vm_get_frame: vm_evict_frame() failed");
-    }
-  } else {  // 성공 시 새 프레임 구조체 할당 후 초기화
-    if ((frame = malloc(sizeof *frame)) == NULL) {
-      palloc_free_page(kaddr);
-      PANIC("vm_get_frame:  malloc(sizeof *frame) failed");
+  if ((frame = rss_reclaim(&thread_current()->spt)) != NULL) return frame;  // 한도면 자기 페이지부터
+  if ((frame = vm_alloc_frame()) == NULL) {  // palloc 실패 시 미리 0으로 채운 프레임, 없으면 evict
+    lock_acquire(&frame_lock);
+    kswapd_wake();
+    frame = zero_pool_take();
+    lock_release(&frame_lock);
+    if (frame == NULL && (frame = mmap_ra_reclaim()) == NULL) {  // 미리 읽어 둔 프레임부터
+      vm_stat.direct_reclaims++;
+      if ((frame = vm_evict_frame(NULL, true)) == NULL) {
+        PANIC("vm_get_frame: vm_evict_frame() failed");
+      }
     }
-
-    frame->kva = kaddr;
-    frame->page = NULL;
-    frame->pinned = true;
-    list_push_back(&frame_table, &frame->elem);  // 새 프레임은 테이블에
   }
 
   ASSERT(frame != NULL);
@@ -203,14 +917,320 @@ static struct frame *vm_get_frame(void) {
   return frame;
 }
 
-/* Growing the stack. */
+/* The page-out daemon. Each time it is woken, it frees frames read ahead
+ * and not used yet, then evicts pages, until vm_high_watermark frames are
+ * free or no page can be evicted. */
+static void kswapd(void *aux UNUSED) {
+  for (;;) {
+    sema_down(&kswapd_sema);
+    vm_stat.kswapd_wakeups++;
+    for (;;) {
+      struct frame *frame;
+
+      lock_acquire(&frame_lock);
+      bool enough = free_cnt >= vm_high_watermark;
+      lock_release(&frame_lock);
+      if (enough ||
+          ((frame = mmap_ra_reclaim()) == NULL && (frame = vm_evict_frame(NULL, false)) == NULL))
+        break;
+
+      vm_free_frame(frame);
+      vm_stat.kswapd_reclaimed++;
+    }
+    lock_acquire(&frame_lock);
+    kswapd_awake = false;
+    lock_release(&frame_lock);
+  }
+}
+
+/* Returns a frame for a zero-fill page, from the pre-zeroed ones if
+ * there is one. */
+static struct frame *vm_get_zero_frame(void) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  struct frame *frame;
+
+  if (spt_at_rss_limit(spt)) return vm_get_frame();
+  lock_acquire(&frame_lock);
+  frame = zero_pool_take();
+  if (frame != NULL)
+    vm_stat_inc(spt, zero_hits);
+  else
+    vm_stat_inc(spt, zero_misses);
+  lock_release(&frame_lock);
+  return frame != NULL ? frame : vm_get_frame();
+}
+
+/* The zeroing thread. Each time it is woken, it zeroes frames for the pool
+ * until the pool is full or no more than vm_high_watermark frames are
+ * free. */
+static void prezero(void *aux UNUSED) {
+  if (thread_mlfqs) thread_set_nice(20);
+  for (;;) {
+    for (;;) {
+      struct frame *frame;
+
+      lock_acquire(&frame_lock);
+      bool enough = zero_pool_cnt >= zero_pool_max || free_cnt <= vm_high_watermark;
+      lock_release(&frame_lock);
+      if (enough || (frame = vm_alloc_frame()) == NULL) break;
+
+      memset(frame->kva, 0, PGSIZE);
+      lock_acquire(&frame_lock);
+      frame->zeroed = true;
+      zero_pool[zero_pool_cnt++] = frame;
+      vm_stat.prezeroed++;
+      lock_release(&frame_lock);
+    }
+    lock_acquire(&frame_lock);
+    prezero_awake = false;
+    lock_release(&frame_lock);
+    sema_down(&prezero_sema);
+  }
+}
+
+/* Growing the stack. The new page is zero-fill and gets claimed by the
+ * fault like any other page. */
 static bool vm_stack_growth(void *addr UNUSED) {
-  if (!vm_alloc_page(VM_ANON | VM_MARKER_0, addr, true)) return false;
-  return vm_claim_page(addr);
+  return vm_alloc_page(VM_ANON | VM_MARKER_0, addr, true);
+}
+
+/* Returns true if PAGE is a text page whose frame another process loaded. */
+static bool text_cached(struct page *page) {
+  bool cached;
+
+  if (!page_is_text(page)) return false;
+  lock_acquire(&frame_lock);
+  cached = text_find(page) != NULL;
+  lock_release(&frame_lock);
+  return cached;
+}
+
+/* Maps the text PAGE read-only to the frame another process loaded it
+ * into. Returns false if there is no such frame. */
+static bool vm_share_text(struct page *page) {
+  struct text_frame *t;
+  struct frame *frame;
+  bool succ;
+
+  lock_acquire(&frame_lock);
+  while ((t = text_find(page)) != NULL && t->frame->pinned) cond_wait(&frame_cond, &frame_lock);
+  if (t == NULL) {
+    lock_release(&frame_lock);
+    return false;
+  }
+  frame = t->frame;
+  frame->pinned = true;
+  lock_release(&frame_lock);
+
+  if (VM_TYPE(page->operations->type) == VM_UNINIT) file_backed_bind(page);
+
+  lock_acquire(&frame_lock);
+  frame_attach(frame, page);
+  succ = pml4_set_page(page_pml4(page), page->va, frame->kva, false);
+  if (succ) {
+    vm_policy->access(frame);
+    vm_policy_stats.text++;
+  } else {
+    frame_detach(frame, page);
+  }
+  frame_unpin(frame);
+  lock_release(&frame_lock);
+  return succ;
+}
+
+/* Returns the aux of PAGE if it is still to be loaded from a file, or NULL. */
+static struct file_load_aux *page_file_aux(struct page *page) {
+  if (VM_TYPE(page->operations->type) != VM_UNINIT || page->uninit.init == NULL) return NULL;
+  return page->uninit.aux;
+}
+
+/* Claims PAGE, which is to be loaded from a file, together with the pages
+ * after it that continue the same file, up to MAX in all.
+ * Their contents come from a single file read into a bounce buffer. The
+ * neighbours only get frames that are free without evicting anything. */
+static bool vm_fault_around(struct page *page, size_t max) {
+  struct file_load_aux *aux = page_file_aux(page), *prev = aux, *next;
+  struct page *pages[FAULT_AROUND_MAX];
+  size_t cnt = 1, bytes = aux->read_bytes, i;
+  uint8_t *buf;
+  bool succ;
+
+  if (text_cached(page)) return vm_do_claim_page(page);
+  pages[0] = page;
+  while (cnt < max && cnt < FAULT_AROUND_MAX && prev->read_bytes == PGSIZE) {
+    struct page *p = spt_find_page(page->spt, (uint8_t *)page->va + cnt * PGSIZE);
+
+    if (p == NULL || p->frame != NULL || (next = page_file_aux(p)) == NULL) break;
+    if (p->uninit.init != page->uninit.init || next->read_bytes == 0 ||
+        next->file_ofs != prev->file_ofs + PGSIZE ||
+        file_get_inode(next->file) != file_get_inode(aux->file) || text_cached(p))
+      break;
+    pages[cnt++] = p;
+    bytes += next->read_bytes;
+    prev = next;
+  }
+  if (cnt == 1) return vm_do_claim_page(page);
+
+  buf = palloc_get_multiple(0, DIV_ROUND_UP(bytes, PGSIZE));
+  if (buf == NULL) return vm_do_claim_page(page);
+  if (file_read_at(aux->file, buf, bytes, aux->file_ofs) != (off_t)bytes) {
+    palloc_free_multiple(buf, DIV_ROUND_UP(bytes, PGSIZE));
+    return vm_do_claim_page(page);
+  }
+  vm_stat_inc(page->spt, file_reads);
+  for (i = 0; i < cnt; i++) page_file_aux(pages[i])->prefetch = buf + i * PGSIZE;
+
+  // aux는 로드 후 해제되므로 채우지 못한 이웃의 prefetch만 되돌림
+  succ = vm_do_claim_page(page);
+  for (i = 1; i < cnt; i++) {
+    struct frame *frame;
+    if (spt_at_rss_limit(page->spt) || (frame = vm_alloc_frame()) == NULL) break;
+    vm_fill_frame(pages[i], frame, true);
+  }
+  for (; i < cnt; i++) page_file_aux(pages[i])->prefetch = NULL;
+
+  palloc_free_multiple(buf, DIV_ROUND_UP(bytes, PGSIZE));
+  return succ;
+}
+
+/* Clears the accessed bit of the file page DROP_BEHIND pages before VA in
+ * VMA, which is read sequentially, so that the replacement policy takes it
+ * before pages that may still be used. */
+static void vm_drop_behind(struct supplemental_page_table *spt, struct vma *vma, uint8_t *va) {
+  struct page *p;
+
+  if (va < vma->start + DROP_BEHIND * PGSIZE) return;
+  p = spt_lookup_page(spt, va - DROP_BEHIND * PGSIZE);
+  if (p == NULL || page_get_type(p) != VM_FILE) return;
+  lock_acquire(&frame_lock);
+  if (p->frame != NULL && !p->frame->pinned) pml4_set_accessed(page_pml4(p), p->va, false);
+  lock_release(&frame_lock);
+}
+
+/* Returns true if the page of SPT at VA is a writable zero-fill page
+ * without a frame, or would be created as one from its region. Does not
+ * create the page. */
+static bool huge_candidate(struct supplemental_page_table *spt, uint8_t *va) {
+  struct page *p = spt_lookup_page(spt, va);
+  struct vma *vma;
+  off_t ofs;
+  size_t read_bytes;
+
+  if (p != NULL) return p->frame == NULL && p->writable && page_is_zero_fill(p);
+  if ((vma = vma_find(spt, va)) == NULL || !vma->writable || !vma->zero_anon) return false;
+  vma_page_layout(vma, va, &ofs, &read_bytes);
+  return read_bytes == 0;
+}
+
+/* Maps the huge page around the zero-fill PAGE, for its first write.
+ * Returns false, having mapped nothing, if the range does not qualify or
+ * no aligned run of frames is free; the fault then claims PAGE alone. */
+static bool vm_claim_huge(struct page *page) {
+  struct supplemental_page_table *spt = page->spt;
+  uint64_t *pml4 = page_pml4(page);
+  uint8_t *base = (uint8_t *)((uint64_t)page->va & ~HUGE_PGMASK);
+  uint8_t *kva;
+  size_t i;
+
+  if (!vm_huge_pages || (spt->rss_limit != 0 && spt->resident + HUGE_PGCNT > spt->rss_limit) ||
+      !huge_candidate(spt, base) || !huge_candidate(spt, base + HUGE_PGSIZE - PGSIZE))
+    return false;
+  for (i = 0; i < HUGE_PGCNT; i++)
+    if (!huge_candidate(spt, base + i * PGSIZE)) return false;
+
+  kva = palloc_get_aligned(PAL_USER | PAL_ZERO, HUGE_PGCNT, HUGE_PGCNT);
+  if (kva == NULL) return false;
+
+  /* Create the pages the range still lacks and map the frames before any
+   * page takes one, so that a failure only has the frames to give back. */
+  for (i = 0; i < HUGE_PGCNT; i++) {
+    struct page *p = spt_find_page(spt, base + i * PGSIZE);
+
+    if (p == NULL) goto fail;
+    if (page_maps_zero(p)) pml4_clear_page(pml4, p->va);
+  }
+  // 큰 페이지 매핑이 안 되면 같은 프레임들을 4 KiB씩 매핑
+  if (pml4_set_huge_page(pml4, base, kva, true)) {
+    vm_stat_inc(spt, huge_pages);
+  } else {
+    for (i = 0; i < HUGE_PGCNT; i++)
+      if (!pml4_set_page(pml4, base + i * PGSIZE, kva + i * PGSIZE, true)) {
+        while (i-- > 0) pml4_clear_page(pml4, base + i * PGSIZE);
+        goto fail;
+      }
+  }
+
+  /* The frames come zeroed, so the pages skip uninit_initialize(). */
+  lock_acquire(&frame_lock);
+  for (i = 0; i < HUGE_PGCNT; i++) {
+    struct page *p = spt_lookup_page(spt, base + i * PGSIZE);
+    struct frame *frame = frame_of(kva + i * PGSIZE);
+
+    p->uninit.page_initializer(p, p->uninit.type, frame->kva);
+    ASSERT(!frame->pinned && frame->ref_cnt == 0);
+    frame->pinned = true;
+    frame_attach(frame, p);
+  }
+  free_cnt -= HUGE_PGCNT;
+  if (free_cnt < vm_low_watermark) kswapd_wake();
+
+  vm_policy_stats.faults++;
+  spt_note_fault(spt, false);
+  for (i = 0; i < HUGE_PGCNT; i++) {
+    struct frame *frame = frame_of(kva + i * PGSIZE);
+
+    vm_policy->insert(frame, VM_NO_REFAULT);
+    frame->pinned = false;
+  }
+  cond_broadcast(&frame_cond, &frame_lock);
+  lock_release(&frame_lock);
+  return true;
+
+fail:
+  palloc_free_multiple(kva, HUGE_PGCNT);
+  return false;
 }
 
-/* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED) {}
+/* Handle the fault on write_protected page.
+ * PAGE is writable but its frame is mapped read-only because it is shared
+ * with another process since fork. The last sharer just gets its mapping
+ * upgraded; everybody else gets a private copy of the frame. */
+static bool vm_handle_wp(struct page *page) {
+  struct frame *frame, *copy;
+  bool succ;
+
+  lock_acquire(&frame_lock);
+  frame = page_pin_frame(page);
+  if (frame == NULL) {  // evicted meanwhile, the retried access will fault it in
+    lock_release(&frame_lock);
+    return true;
+  }
+  if (frame->ref_cnt == 1) {
+    pml4_set_writable(page_pml4(page), page->va, true);
+    vm_policy->access(frame);
+    frame_unpin(frame);
+    lock_release(&frame_lock);
+    return true;
+  }
+  lock_release(&frame_lock);
+
+  copy = vm_get_frame();
+  memcpy(copy->kva, frame->kva, PGSIZE);
+
+  lock_acquire(&frame_lock);
+  pml4_clear_page(page_pml4(page), page->va);
+  frame_detach(frame, page);
+  if (frame->ref_cnt == 0)
+    frame_free(frame);
+  else
+    frame_unpin(frame);
+  frame_attach(copy, page);
+  succ = pml4_set_page(page_pml4(page), page->va, copy->kva, true);
+  vm_policy->insert(copy, VM_NO_REFAULT);
+  frame_unpin(copy);
+  lock_release(&frame_lock);
+  return succ;
+}
 
 bool valid_stack_growth(void *addr, struct intr_frame *f, bool user) {
   // u -> k 때만 프레임 저장, 커널 발생 fault는 rsp 별도 처리
@@ -219,27 +1239,121 @@ bool valid_stack_growth(void *addr, struct intr_frame *f, bool user) {
   return (addr < USER_STACK) && near_rsp && (addr >= MIN_STACK_ADDR);
 }
 
-/* Return true on success */
-bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED, bool user UNUSED,
-                         bool write UNUSED, bool not_present UNUSED) {
+static bool vm_handle_fault(struct intr_frame *f, void *addr, bool user, bool write,
+                            bool not_present) {
   struct supplemental_page_table *spt = &thread_current()->spt;
   struct page *page = NULL;
   /* TODO: Validate the fault */
   /* TODO: Your code goes here */
   if (addr == NULL || !is_user_vaddr(addr)) return false;  // addr valid
-  if (!not_present) return false;                          // 보호 위반 여부
 
   void *va = pg_round_down(addr);
   page = spt_find_page(&thread_current()->spt, va);
 
+  if (!not_present) {  // 보호 위반: copy-on-write 또는 zero 페이지에 대한 쓰기만 허용
+    if (!write || page == NULL || !page->writable) return false;
+    if (page_maps_zero(page)) return vm_claim_huge(page) || vm_do_claim_page(page);
+    return vm_handle_wp(page);
+  }
+
   if (!page) {
     if (!valid_stack_growth(addr, f, user)) return false;  //  스택 성장 가능 체크
-    return vm_stack_growth(va);                            // stack growth
+    if (!vm_stack_growth(va)) return false;                // stack growth
+    vm_stat_inc(spt, stack_faults);
+    page = spt_find_page(spt, va);
   }
   if (write && !page->writable) return false;  // write 동작에, 페이지가 지원안할 때
+  if (!write && page_is_zero_fill(page)) return page_map_zero(page);  // 읽기는 zero 프레임으로
+  if (page_is_zero_fill(page) && vm_claim_huge(page)) return true;
+  if (page_file_aux(page) != NULL) {
+    struct vma *vma = vma_find(spt, va);
+    int advice = vma != NULL ? vma->advice : MADV_NORMAL;
+    size_t around = advice == MADV_SEQUENTIAL ? FAULT_AROUND_MAX : fault_around_pages;
+    bool stream;
+    struct frame *frame;
+
+    if (advice == MADV_RANDOM) return vm_do_claim_page(page);
+    if (advice == MADV_SEQUENTIAL) vm_drop_behind(spt, vma, va);
+    frame = mmap_readahead(page, &stream);
+    if (frame != NULL) return vm_fill_frame(page, frame, false);
+    if (!stream && around > 1) return vm_fault_around(page, around);
+  }
+  if (VM_TYPE(page->operations->type) == VM_ANON && page->frame == NULL) {
+    struct frame *frame = swap_readahead(page);
+
+    if (frame != NULL) return vm_fill_frame(page, frame, false);
+  }
   return vm_do_claim_page(page);
 }
 
+/* Return true on success.
+ * A fault is major if serving it read from swap or from a file. */
+bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED, bool user UNUSED,
+                         bool write UNUSED, bool not_present UNUSED) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  uint64_t reads = spt->stat.swap_ins + spt->stat.file_reads;
+  uint64_t start = rdtsc(), cycles;
+  size_t bucket = 0;
+
+  if (!vm_handle_fault(f, addr, user, write, not_present)) return false;
+
+  cycles = rdtsc() - start;
+  while (bucket + 1 < VMSTAT_LAT_BUCKETS && cycles >= (uint64_t)VMSTAT_LAT_BASE << bucket) bucket++;
+  vm_stat_inc(spt, fault_latency[bucket]);
+  if (spt->stat.swap_ins + spt->stat.file_reads != reads)
+    vm_stat_inc(spt, major_faults);
+  else
+    vm_stat_inc(spt, minor_faults);
+  return true;
+}
+
+/* Stores the counters of the current process, or of the whole system if
+ * SYSTEM, in STAT, together with the current and peak number of frames it
+ * maps. */
+void vm_get_stat(struct vmstat *stat, bool system) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  struct vmstat s;
+
+  lock_acquire(&frame_lock);
+  s = system ? vm_stat : spt->stat;
+  s.rss = system ? frame_cnt - free_cnt : spt->resident;
+  s.rss_peak = system ? used_peak : spt->rss_peak;
+  s.rss_limit = system ? 0 : spt->rss_limit;
+  lock_release(&frame_lock);
+  *stat = s;  // 사용자 메모리는 락 밖에서 씀
+}
+
+/* Prints the counters of the whole system. */
+void vm_print_stats(void) {
+  struct vmstat *s = &vm_stat;
+
+  printf("VM: %llu minor faults, %llu major faults, %llu stack faults\n", s->minor_faults,
+         s->major_faults, s->stack_faults);
+  printf("VM: %llu swap-ins, %llu swap-outs, %llu file reads, %llu writebacks\n", s->swap_ins,
+         s->swap_outs, s->file_reads, s->writebacks);
+  printf("VM: %zu frames in use at most, %llu evictions at resident set limits\n", used_peak,
+         s->rss_reclaims);
+  printf("VM: %llu evictions (%llu anon, %llu file, %llu text), %llu frames swept\n",
+         s->evictions_anon + s->evictions_file + s->evictions_text, s->evictions_anon,
+         s->evictions_file, s->evictions_text, s->clock_sweeps);
+  printf("VM: page-out daemon woken %llu times, %llu frames reclaimed, %llu direct reclaims\n",
+         s->kswapd_wakeups, s->kswapd_reclaimed, s->direct_reclaims);
+  printf("VM: %llu huge pages mapped, %llu split\n", s->huge_pages, s->huge_splits);
+  printf("VM: %llu frames pre-zeroed, %llu zero-fill hits, %llu misses\n", s->prezeroed,
+         s->zero_hits, s->zero_misses);
+  printf("VM: %llu pages unmapped in batches, %llu full TLB flushes\n", s->batched_unmaps,
+         s->tlb_flushes);
+  if (s->teardown_pages > 0)
+    printf("VM: %llu address spaces torn down, %llu pages, %llu cycles per page\n", s->teardowns,
+           s->teardown_pages, s->teardown_cycles / s->teardown_pages);
+  printf("VM: fault latency in cycles:");
+  for (size_t i = 0; i + 1 < VMSTAT_LAT_BUCKETS; i++)
+    if (s->fault_latency[i] != 0)
+      printf(" <%llu: %llu", (unsigned long long)VMSTAT_LAT_BASE << i, s->fault_latency[i]);
+  printf(" >=%llu: %llu\n", (unsigned long long)VMSTAT_LAT_BASE << (VMSTAT_LAT_BUCKETS - 2),
+         s->fault_latency[VMSTAT_LAT_BUCKETS - 1]);
+}
+
 /* Free the page.
  * DO NOT MODIFY THIS FUNCTION. */
 void vm_dealloc_page(struct page *page) {
@@ -260,25 +1374,137 @@ bool vm_claim_page(void *va UNUSED) {
 
 /* Claim the PAGE and set up the mmu. */
 static bool vm_do_claim_page(struct page *page) {
-  struct frame *frame = vm_get_frame();
+  struct frame *frame;
+  bool resident;
+
+  /* A fault may race with the eviction of this very page; wait for it. */
+  lock_acquire(&frame_lock);
+  while (page->frame != NULL && page->frame->pinned) cond_wait(&frame_cond, &frame_lock);
+  resident = page->frame != NULL;
+  lock_release(&frame_lock);
+  if (resident) return true;
+  if (page_maps_zero(page)) pml4_clear_page(page_pml4(page), page->va);
+  if (page_is_text(page) && vm_share_text(page)) return true;
+
+  frame = page_is_zero_fill(page) ? vm_get_zero_frame() : vm_get_frame();
+  return vm_fill_frame(page, frame, false);
+}
+
+/* Fills FRAME, which is pinned and has no pages, with the contents of PAGE
+ * and maps it. SPECULATIVE fills map pages ahead of use and are not
+ * counted as faults. */
+static bool vm_fill_frame(struct page *page, struct frame *frame, bool speculative) {
+  bool zeroed = frame->zeroed && page_is_zero_fill(page);
+  struct frame *own;
+
+  // 미리 읽어 둔 프레임으로 폴트를 처리할 때도 한도를 지킴
+  if (!speculative && (own = rss_reclaim(page->spt)) != NULL) vm_free_frame(own);
 
   /* Set links */
-  frame->page = page;
-  page->frame = frame;
+  lock_acquire(&frame_lock);
+  frame_attach(frame, page);
+  lock_release(&frame_lock);
 
-  /* TODO: Insert page table entry to map page's VA to frame's PA. */
-  bool succ = pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable);
-  frame->pinned = false;
+  /* Fill the frame before it becomes visible to the process. A zero-fill
+   * page on a zeroed frame skips uninit_initialize(). */
+  bool succ = (zeroed ? page->uninit.page_initializer(page, page->uninit.type, frame->kva)
+                      : swap_in(page, frame->kva)) &&
+              pml4_set_page(page_pml4(page), page->va, frame->kva, page->writable);
 
-  if (!succ) {
-    frame->page = NULL;
-    page->frame = NULL;
-    palloc_free_page(frame->kva);
-    free(frame);
-    return false;
+  lock_acquire(&frame_lock);
+  if (succ && speculative) {
+    vm_policy_stats.around++;
+  } else if (succ) {
+    vm_policy_stats.faults++;
+    if (page->evict_stamp != 0) vm_policy_stats.refaults++;
+    spt_note_fault(page->spt, page->evict_stamp != 0);
+  }
+  if (succ) {
+    vm_policy->insert(frame, page->evict_stamp != 0 ? (uint32_t)(evict_clock - page->evict_stamp)
+                                                    : VM_NO_REFAULT);
+    if (page_is_text(page)) text_insert(frame, page);
+    frame_unpin(frame);
+  } else {
+    frame_detach(frame, page);
+    frame_free(frame);
+  }
+  lock_release(&frame_lock);
+  return succ;
+}
+
+/* Starts bringing in the pages from START to END that are to be read from
+ * swap or a file. The pages of mmaps are read by the read-ahead thread;
+ * the others are read right away, but only into frames that are free
+ * without evicting anything. */
+static void vm_willneed(struct supplemental_page_table *spt, uint8_t *start, uint8_t *end) {
+  for (uint8_t *va = start; va < end; va += PGSIZE) {
+    struct vma *vma = vma_find(spt, va);
+    struct page *p;
+    struct frame *frame;
+
+    if (vma != NULL && vma->mmap != NULL) {
+      uint8_t *stop = end < vma->end ? end : vma->end;
+
+      mmap_willneed(vma->mmap, va, stop);
+      va = stop - PGSIZE;
+      continue;
+    }
+    p = spt_find_page(spt, va);
+    // 이미 올라와 있거나 읽을 내용이 없는 페이지는 건너뜀
+    if (p == NULL || p->frame != NULL || page_is_zero_fill(p) || page_maps_zero(p)) continue;
+    if (page_is_text(p) && vm_share_text(p)) continue;
+    if (spt_at_rss_limit(spt) || (frame = vm_alloc_frame()) == NULL) return;
+    vm_fill_frame(p, frame, true);
+  }
+}
+
+/* Discards the pages from START to END, freeing their frames and swap
+ * slots. Dirty mmap pages are written back first. A page of a region is
+ * created again from the region when next used; any other page comes
+ * back as a zero-fill page. */
+static bool vm_dontneed(struct supplemental_page_table *spt, uint8_t *start, uint8_t *end) {
+  mmap_writeback_range(start, end);
+  for (uint8_t *va = start; va < end; va += PGSIZE) {
+    struct page *p = spt_lookup_page(spt, va);
+    bool writable;
+
+    if (p == NULL) continue;
+    writable = p->writable;
+    spt_remove_page(spt, p);
+    if (vma_find(spt, va) == NULL && !vm_alloc_page(VM_ANON, va, writable)) return false;
   }
+  return true;
+}
+
+/* Takes ADVICE, one of MADV_*, about the LENGTH bytes from ADDR, which is
+ * page-aligned. Every page of the range must be mapped.
+ * MADV_NORMAL, MADV_RANDOM and MADV_SEQUENTIAL are kept by the regions
+ * the range overlaps, for the whole of each region, and change how faults
+ * on them read ahead. Pages outside regions never read ahead, so these
+ * leave them alone. */
+bool do_madvise(void *addr, size_t length, int advice) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  uint8_t *start = addr, *end = start + ROUND_UP(length, PGSIZE), *va;
+  struct vma *vma;
 
-  return swap_in(page, frame->kva);
+  for (va = start; va < end; va += PGSIZE)
+    if (spt_lookup_page(spt, va) == NULL && vma_find(spt, va) == NULL) return false;
+
+  switch (advice) {
+    case MADV_NORMAL:
+    case MADV_RANDOM:
+    case MADV_SEQUENTIAL:
+      for (va = start; va < end; va = vma != NULL ? vma->end : va + PGSIZE)
+        if ((vma = vma_find(spt, va)) != NULL) vma->advice = advice;
+      return true;
+    case MADV_WILLNEED:
+      vm_willneed(spt, start, end);
+      return true;
+    case MADV_DONTNEED:
+      return vm_dontneed(spt, start, end);
+    default:
+      return false;
+  }
 }
 
 static uint64_t hash_func(const struct hash_elem *e, void *aux) {
@@ -293,70 +1519,187 @@ static bool less_func(const struct hash_elem *a, const struct hash_elem *b, void
   return pa->va < pb->va;  // less
 }
 
+static uint64_t text_hash(const struct hash_elem *e, void *aux UNUSED) {
+  const struct text_frame *t = hash_entry(e, struct text_frame, elem);
+  return hash_bytes(&t->inode, sizeof t->inode) ^ hash_int(t->ofs);
+}
+
+static bool text_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+  const struct text_frame *ta = hash_entry(a, struct text_frame, elem);
+  const struct text_frame *tb = hash_entry(b, struct text_frame, elem);
+  return ta->inode != tb->inode ? ta->inode < tb->inode : ta->ofs < tb->ofs;
+}
+
 /* Initialize new supplemental page table */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED) {
   ASSERT(spt != NULL);
 
   // spt->hash_table = malloc(sizeof *spt->hash_table);
   hash_init(&spt->hash_table, hash_func, less_func, NULL);
+  spt->vmas = NULL;
+  spt->resident = 0;
+  spt->target = PFF_MIN_TARGET;
+  spt->over = false;
+  spt->wss = 0;
+  spt->window_start = timer_ticks();
+  spt->window_refaults = 0;
+  spt->stat = (struct vmstat){0};
+  spt->swap_cluster_cnt = spt->swap_cluster_hand = 0;
+  spt->rss_limit = vm_rss_limit;
+  spt->rss_peak = 0;
+}
+
+/* Makes DST, a page of the current process, share the anonymous page SRC
+ * copy-on-write: a resident frame is mapped read-only into both address
+ * spaces and a swapped-out page shares its swap slot. */
+static bool page_share(struct supplemental_page_table *dst, struct page *src) {
+  struct page *page;
+  struct frame *frame;
+  bool succ = true;
+
+  if (!vm_alloc_page(VM_ANON, src->va, src->writable)) return false;
+  page = spt_find_page(dst, src->va);
+  anon_initializer(page, VM_ANON, NULL);
+
+  lock_acquire(&frame_lock);
+  frame = page_pin_frame(src);
+  if (frame != NULL) {
+    frame_attach(frame, page);
+    succ = pml4_set_page(page_pml4(page), page->va, frame->kva, false);
+    if (succ) {
+      page_split_huge(src);
+      pml4_set_writable(page_pml4(src), src->va, false);
+    }
+    else
+      frame_detach(frame, page);
+    frame_unpin(frame);
+  } else {
+    anon_dup_slot(page, src);
+  }
+  lock_release(&frame_lock);
+  return succ;
+}
+
+/* Gives the current process the text page SRC, to be loaded lazily. Its
+ * fault maps the frame of SRC if that is still resident. */
+static bool page_copy_text(struct page *src) {
+  struct file_load_aux *aux = malloc(sizeof *aux);
+
+  if (aux == NULL) return false;
+  *aux = (struct file_load_aux){.file = file_reopen(src->file.file),
+                                .file_ofs = src->file.ofs,
+                                .read_bytes = src->file.read_bytes};
+  if (!vm_alloc_page_with_initializer(VM_FILE | VM_TEXT, src->va, false, lazy_load_file, aux)) {
+    free(aux);
+    return false;
+  }
+  return true;
 }
 
-// void uninit_page_copy() {}
-// void anon_page_copy() {}
+/* Gives the current process, whose table is DST, a copy of the segment
+ * VMA. The regions of mmaps are not inherited. */
+static bool vma_copy_segment(struct vma *vma, void *dst) {
+  struct vma *copy;
+
+  if (vma->mmap != NULL) return true;
+  if ((copy = malloc(sizeof *copy)) == NULL) return false;
+  *copy = *vma;
+  copy->file = file_reopen(vma->file);
+  copy->owns_file = true;
+  if (copy->file == NULL || !vma_insert(dst, copy)) {
+    file_close(copy->file);
+    free(copy);
+    return false;
+  }
+  return true;
+}
 
-/* Copy supplemental page table from src to dst */
+/* Copy supplemental page table from src to dst.
+ * Anonymous pages are shared copy-on-write, pages never touched by the
+ * parent stay lazy in the child. Segment regions are copied whole; the
+ * child creates their pages again on first use. */
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
                                   struct supplemental_page_table *src UNUSED) {
-  bool succ = false;
   ASSERT(&thread_current()->spt == dst);  // dst가 현재 쓰레드여야함
 
+  dst->rss_limit = src->rss_limit;
   struct hash_iterator i;
   hash_first(&i, &src->hash_table);
 
   while (hash_next(&i)) {
     struct page *src_page = hash_entry(hash_cur(&i), struct page, hash_elem);
     enum vm_type type = VM_TYPE(src_page->operations->type);
-    bool writable = src_page->writable;
-    struct uninit_page uninit = src_page->uninit;
-    struct load_aux *old_aux = src_page->uninit.aux;
+    struct uninit_page *uninit = &src_page->uninit;
     void *va = src_page->va;
+    struct vma *vma = vma_find(src, va);
     ASSERT(va == pg_round_down(va));
+    if (type == VM_UNINIT && vma != NULL && vma->mmap == NULL) continue;  // 자식의 영역이 만듦
 
     switch (type) {
-      case VM_UNINIT:
-        struct load_aux *new_aux = malloc(sizeof *new_aux);
-        *new_aux = *old_aux;
-        new_aux->file = file_reopen(old_aux->file);  // reopen(pos 복사안함) <-> duplicate
-        if (!vm_alloc_page_with_initializer(uninit.type, va, writable, uninit.init, new_aux)) {
+      case VM_UNINIT: {
+        // mmap 은 상속하지 않음
+        if (VM_TYPE(uninit->type) != VM_ANON && !(uninit->type & VM_TEXT)) break;
+
+        struct file_load_aux *new_aux = NULL;
+        if (uninit->aux != NULL) {
+          struct file_load_aux *old_aux = uninit->aux;
+          if ((new_aux = malloc(sizeof *new_aux)) == NULL) return false;
+          *new_aux = *old_aux;
+          new_aux->file = file_reopen(old_aux->file);  // reopen(pos 복사안함) <-> duplicate
+        }
+        if (!vm_alloc_page_with_initializer(uninit->type, va, src_page->writable, uninit->init,
+                                            new_aux)) {
+          free(new_aux);
           return false;
         }
-        succ = vm_claim_page(va);  // 즉시 클레임
         break;
+      }
       case VM_ANON:
-        bool is_in = src_page->frame != NULL;
-
-        if (!vm_alloc_page(VM_ANON, va, writable)) {
-          return false;
-        }
-        succ = vm_claim_page(va);
-        memcpy(spt_find_page(dst, va)->frame->kva, src_page->frame->kva, PGSIZE);
+        if (!page_share(dst, src_page)) return false;
+        break;
+      case VM_FILE:
+        if (src_page->file.text && !page_copy_text(src_page)) return false;
         break;
       default:
         break;
     }
   }
 
-  return succ;
+  return vma_for_each(src, vma_copy_segment, dst);
 }
 
-static void page_destory(struct hash_elem *e, void *aux) {
+/* Frees the page of E, destroyed by kill_batch_unmap() already, and its
+ * frame. Called with frame_lock held. */
+static void page_free(struct hash_elem *e, void *aux UNUSED) {
   struct page *p = hash_entry(e, struct page, hash_elem);
-  destroy(p);
+
+  if (p->frame != NULL) frame_put(p);
+  free(p);
 }
 
 /* Free the resource hold by the supplemental page table */
 void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED) {
   /* TODO: Destroy all the supplemental_page_table hold by thread and
-   * TODO: writeback all the modified contents to the storage. */
-  hash_clear(spt, page_destory);
+   * TODO: writeback all the modified contents to the storage.
+   * Frames must be unmapped here: pml4_destroy() would otherwise free
+   * frames that are still shared with other processes. */
+  struct kill_batch b;
+  struct hash_iterator i;
+  size_t cnt = hash_size(&spt->hash_table);
+  uint64_t start = rdtsc();
+
+  kill_batch_init(&b, spt);
+  hash_first(&i, &spt->hash_table);
+  while (hash_next(&i)) kill_batch_add(&b, hash_entry(hash_cur(&i), struct page, hash_elem));
+  kill_batch_flush(&b);
+  lock_acquire(&frame_lock);
+  hash_clear(&spt->hash_table, page_free);
+  lock_release(&frame_lock);
+  vma_kill_all(spt);
+
+  if (cnt > 0) {
+    vm_stat.teardowns++;
+    vm_stat.teardown_pages += cnt;
+    vm_stat.teardown_cycles += rdtsc() - start;
+  }
 }
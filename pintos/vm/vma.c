@@ -0,0 +1,193 @@
+/* vma.c: Regions of a process's address space.
+ *
+ * Each process keeps its regions in an AVL tree ordered by start address.
+ * Regions never overlap, so the region holding an address is found by a
+ * single descent, and mapping or unmapping a region takes time logarithmic
+ * in the number of regions rather than linear in their pages. */
+
+#include "vm/vma.h"
+
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+static int height(const struct vma *v) { return v != NULL ? v->height : 0; }
+
+static void update(struct vma *v) {
+  int l = height(v->left), r = height(v->right);
+  v->height = (l > r ? l : r) + 1;
+}
+
+static struct vma *rotate_right(struct vma *v) {
+  struct vma *l = v->left;
+
+  v->left = l->right;
+  l->right = v;
+  update(v);
+  update(l);
+  return l;
+}
+
+static struct vma *rotate_left(struct vma *v) {
+  struct vma *r = v->right;
+
+  v->right = r->left;
+  r->left = v;
+  update(v);
+  update(r);
+  return r;
+}
+
+/* Restores the AVL invariant at V, whose subtrees are balanced, and
+ * returns the new root of the subtree. */
+static struct vma *rebalance(struct vma *v) {
+  int balance;
+
+  update(v);
+  balance = height(v->left) - height(v->right);
+  if (balance > 1) {
+    if (height(v->left->left) < height(v->left->right)) v->left = rotate_left(v->left);
+    return rotate_right(v);
+  }
+  if (balance < -1) {
+    if (height(v->right->right) < height(v->right->left)) v->right = rotate_right(v->right);
+    return rotate_left(v);
+  }
+  return v;
+}
+
+static struct vma *tree_insert(struct vma *root, struct vma *vma) {
+  if (root == NULL) return vma;
+  if (vma->start < root->start)
+    root->left = tree_insert(root->left, vma);
+  else
+    root->right = tree_insert(root->right, vma);
+  return rebalance(root);
+}
+
+/* Unlinks the leftmost region of ROOT, stores it in *MIN, and returns the
+ * new root. */
+static struct vma *remove_min(struct vma *root, struct vma **min) {
+  if (root->left == NULL) {
+    *min = root;
+    return root->right;
+  }
+  root->left = remove_min(root->left, min);
+  return rebalance(root);
+}
+
+static struct vma *tree_remove(struct vma *root, struct vma *vma) {
+  struct vma *min;
+
+  ASSERT(root != NULL);
+  if (vma->start < root->start) {
+    root->left = tree_remove(root->left, vma);
+  } else if (vma->start > root->start) {
+    root->right = tree_remove(root->right, vma);
+  } else {
+    ASSERT(root == vma);
+    if (vma->right == NULL) return vma->left;
+    vma->right = remove_min(vma->right, &min);
+    min->left = vma->left;
+    min->right = vma->right;
+    root = min;
+  }
+  return rebalance(root);
+}
+
+/* Adds VMA to the regions of SPT. Returns false if it overlaps one of
+ * them. */
+bool vma_insert(struct supplemental_page_table *spt, struct vma *vma) {
+  ASSERT(vma->start < vma->end);
+
+  if (vma_overlaps(spt, vma->start, vma->end)) return false;
+  vma->left = vma->right = NULL;
+  vma->height = 1;
+  spt->vmas = tree_insert(spt->vmas, vma);
+  return true;
+}
+
+/* Removes VMA from the regions of SPT without freeing it. */
+void vma_remove(struct supplemental_page_table *spt, struct vma *vma) {
+  spt->vmas = tree_remove(spt->vmas, vma);
+  vma->left = vma->right = NULL;
+}
+
+/* Returns the region of SPT holding VA, or NULL. */
+struct vma *vma_find(struct supplemental_page_table *spt, const void *va) {
+  struct vma *v = spt->vmas;
+
+  while (v != NULL) {
+    if ((const uint8_t *)va < v->start)
+      v = v->left;
+    else if ((const uint8_t *)va >= v->end)
+      v = v->right;
+    else
+      return v;
+  }
+  return NULL;
+}
+
+/* Returns true if a region of SPT overlaps [START, END). */
+bool vma_overlaps(struct supplemental_page_table *spt, const void *start, const void *end) {
+  struct vma *v = spt->vmas;
+
+  while (v != NULL) {
+    if ((const uint8_t *)end <= v->start)
+      v = v->left;
+    else if ((const uint8_t *)start >= v->end)
+      v = v->right;
+    else
+      return true;
+  }
+  return false;
+}
+
+/* Stores the file offset and the number of bytes to read from the file of
+ * the page of VMA at VA. */
+void vma_page_layout(const struct vma *vma, const void *va, off_t *ofs, size_t *read_bytes) {
+  size_t skip = (const uint8_t *)va - vma->start;
+
+  ASSERT((const uint8_t *)va >= vma->start && (const uint8_t *)va < vma->end);
+  *ofs = vma->ofs + skip;
+  *read_bytes = skip >= vma->read_bytes ? 0
+                : vma->read_bytes - skip < PGSIZE ? vma->read_bytes - skip
+                                                  : PGSIZE;
+}
+
+/* Frees VMA, which is no longer in a tree, with its file and mmap. */
+void vma_destroy(struct vma *vma) {
+  if (vma->mmap != NULL) {
+    list_remove(&vma->mmap->elem);
+    free(vma->mmap);
+  }
+  if (vma->owns_file) file_close(vma->file);
+  free(vma);
+}
+
+static bool for_each(struct vma *v, bool (*func)(struct vma *, void *aux), void *aux) {
+  return v == NULL ||
+         (for_each(v->left, func, aux) && func(v, aux) && for_each(v->right, func, aux));
+}
+
+/* Calls FUNC on every region of SPT in address order, until it returns
+ * false. Returns false if FUNC did. FUNC must not change the regions of
+ * SPT. */
+bool vma_for_each(struct supplemental_page_table *spt, bool (*func)(struct vma *, void *aux),
+                  void *aux) {
+  return for_each(spt->vmas, func, aux);
+}
+
+static void kill_all(struct vma *v) {
+  if (v == NULL) return;
+  kill_all(v->left);
+  kill_all(v->right);
+  vma_destroy(v);
+}
+
+/* Destroys every region of SPT. */
+void vma_kill_all(struct supplemental_page_table *spt) {
+  kill_all(spt->vmas);
+  spt->vmas = NULL;
+}
@@ -0,0 +1,299 @@
+/* zswap.c: Compressed in-memory cache in front of the swap disk.
+ *
+ * An anonymous page being swapped out is first compressed with a small
+ * LZ4-style compressor and kept in a pool of at most zswap_budget pages of
+ * kernel memory, keyed by the swap slot reserved for it. The disk is only
+ * written when the pool is full: then the least recently used entry is
+ * decompressed and written back to its slot. */
+
+#include "vm/zswap.h"
+
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hash.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Pages compressing worse than this go straight to disk. */
+#define ZSWAP_MAX_LEN (PGSIZE - PGSIZE / 4)
+
+/* A compressed page. */
+struct zswap_entry {
+  size_t slot;                /* Swap slot the page belongs to. */
+  size_t len;                 /* Size of DATA in bytes. */
+  struct hash_elem hash_elem; /* Element of `entries'. */
+  struct list_elem lru_elem;  /* Element of `lru'. */
+  uint8_t data[];             /* Compressed contents. */
+};
+
+size_t zswap_budget = ZSWAP_DEFAULT_PAGES;
+
+static struct hash entries;  /* Entries keyed by slot. */
+static struct list lru;      /* Entries, least recently used first. */
+static struct lock zswap_lock;
+static size_t pool_bytes;    /* Memory held by all entries. */
+static zswap_writeback_func *writeback_page;
+static uint8_t *scratch;     /* Decompression buffer for write back. */
+static uint8_t zbuf[ZSWAP_MAX_LEN];
+
+/* Statistics. */
+static long long stored_cnt, rejected_cnt, writeback_cnt;
+static long long hit_cnt, miss_cnt;
+static long long orig_bytes, comp_bytes;
+
+/* The compressor. Its output is a sequence of LZ4 block-format sequences:
+ * a token whose high nibble is the literal length and low nibble the match
+ * length minus LZ_MIN_MATCH (15 meaning that extension bytes follow), the
+ * literals, then a 2-byte little-endian match offset. The last sequence has
+ * literals only. */
+
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5 /* Trailing bytes that are always literals. */
+#define LZ_HASH_BITS 12
+
+static uint16_t lz_table[1 << LZ_HASH_BITS]; /* Last position of each 4-byte hash. */
+
+static uint32_t lz_load32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof v);
+  return v;
+}
+
+static size_t lz_hash(uint32_t seq) { return (seq * 2654435761u) >> (32 - LZ_HASH_BITS); }
+
+/* Appends the extension bytes of LEN to DST. */
+static bool lz_put_len(uint8_t *dst, size_t *op, size_t cap, size_t len) {
+  for (; len >= 255; len -= 255) {
+    if (*op >= cap) return false;
+    dst[(*op)++] = 255;
+  }
+  if (*op >= cap) return false;
+  dst[(*op)++] = len;
+  return true;
+}
+
+/* Appends a sequence of LIT_LEN literals from LIT followed by a match of
+ * MATCH_LEN bytes OFFSET bytes back, or no match if MATCH_LEN is 0. Returns
+ * false if DST would exceed CAP bytes. */
+static bool lz_put_seq(uint8_t *dst, size_t *op, size_t cap, const uint8_t *lit, size_t lit_len,
+                       size_t offset, size_t match_len) {
+  size_t ml = match_len != 0 ? match_len - LZ_MIN_MATCH : 0;
+
+  if (*op >= cap) return false;
+  dst[(*op)++] = (lit_len < 15 ? lit_len : 15) << 4 | (ml < 15 ? ml : 15);
+  if (lit_len >= 15 && !lz_put_len(dst, op, cap, lit_len - 15)) return false;
+  if (cap - *op < lit_len) return false;
+  memcpy(dst + *op, lit, lit_len);
+  *op += lit_len;
+  if (match_len == 0) return true;
+
+  if (cap - *op < 2) return false;
+  dst[(*op)++] = offset & 0xff;
+  dst[(*op)++] = offset >> 8;
+  return ml < 15 || lz_put_len(dst, op, cap, ml - 15);
+}
+
+/* Compresses the page at SRC into DST. Returns the compressed size, or 0 if
+ * it does not fit in CAP bytes. */
+static size_t lz_compress(const uint8_t *src, uint8_t *dst, size_t cap) {
+  size_t ip = 0, anchor = 0, op = 0;
+
+  memset(lz_table, 0, sizeof lz_table);
+  while (ip + LZ_MIN_MATCH + LZ_LAST_LITERALS <= PGSIZE) {
+    uint32_t seq = lz_load32(src + ip);
+    size_t h = lz_hash(seq);
+    size_t ref = lz_table[h];
+
+    lz_table[h] = ip;
+    if (ref >= ip || lz_load32(src + ref) != seq) {
+      ip++;
+      continue;
+    }
+
+    size_t len = LZ_MIN_MATCH;
+    while (ip + len < PGSIZE - LZ_LAST_LITERALS && src[ref + len] == src[ip + len]) len++;
+    if (!lz_put_seq(dst, &op, cap, src + anchor, ip - anchor, ip - ref, len)) return 0;
+    ip += len;
+    anchor = ip;
+  }
+  if (!lz_put_seq(dst, &op, cap, src + anchor, PGSIZE - anchor, 0, 0)) return 0;
+  return op;
+}
+
+/* Reads the extension bytes of a length into *LEN. */
+static bool lz_get_len(const uint8_t *src, size_t *ip, size_t len, size_t *out) {
+  uint8_t b;
+
+  do {
+    if (*ip >= len) return false;
+    b = src[(*ip)++];
+    *out += b;
+  } while (b == 255);
+  return true;
+}
+
+/* Decompresses LEN bytes at SRC into the page DST. Returns false if SRC is
+ * not a well-formed compressed page. */
+static bool lz_decompress(const uint8_t *src, size_t len, uint8_t *dst) {
+  size_t ip = 0, op = 0;
+
+  while (ip < len) {
+    uint8_t token = src[ip++];
+    size_t lit = token >> 4, ml = token & 15, offset;
+
+    if (lit == 15 && !lz_get_len(src, &ip, len, &lit)) return false;
+    if (len - ip < lit || PGSIZE - op < lit) return false;
+    memcpy(dst + op, src + ip, lit);
+    ip += lit;
+    op += lit;
+    if (ip == len) break;
+
+    if (len - ip < 2) return false;
+    offset = src[ip] | src[ip + 1] << 8;
+    ip += 2;
+    if (ml == 15 && !lz_get_len(src, &ip, len, &ml)) return false;
+    ml += LZ_MIN_MATCH;
+    if (offset == 0 || offset > op || PGSIZE - op < ml) return false;
+    // 겹치는 매치가 있으므로 바이트 단위로 복사
+    for (; ml > 0; ml--, op++) dst[op] = dst[op - offset];
+  }
+  return op == PGSIZE;
+}
+
+static uint64_t entry_hash(const struct hash_elem *e, void *aux UNUSED) {
+  const struct zswap_entry *entry = hash_entry(e, struct zswap_entry, hash_elem);
+  return hash_bytes(&entry->slot, sizeof entry->slot);
+}
+
+static bool entry_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+  return hash_entry(a, struct zswap_entry, hash_elem)->slot <
+         hash_entry(b, struct zswap_entry, hash_elem)->slot;
+}
+
+static size_t entry_size(size_t len) { return sizeof(struct zswap_entry) + len; }
+
+/* Returns the entry of SLOT, or NULL. Must be called with zswap_lock held. */
+static struct zswap_entry *entry_find(size_t slot) {
+  struct zswap_entry key;
+  struct hash_elem *e;
+
+  key.slot = slot;
+  e = hash_find(&entries, &key.hash_elem);
+  return e != NULL ? hash_entry(e, struct zswap_entry, hash_elem) : NULL;
+}
+
+/* Drops ENTRY from the pool. Must be called with zswap_lock held. */
+static void entry_free(struct zswap_entry *entry) {
+  hash_delete(&entries, &entry->hash_elem);
+  list_remove(&entry->lru_elem);
+  pool_bytes -= entry_size(entry->len);
+  free(entry);
+}
+
+/* Decompresses ENTRY into DST or panics. */
+static void entry_read(struct zswap_entry *entry, void *dst) {
+  if (!lz_decompress(entry->data, entry->len, dst))
+    PANIC("zswap: corrupted entry for slot %zu", entry->slot);
+}
+
+/* Writes the least recently used entry back to disk and drops it. */
+static void writeback_lru(void) {
+  struct zswap_entry *entry = list_entry(list_front(&lru), struct zswap_entry, lru_elem);
+
+  entry_read(entry, scratch);
+  writeback_page(entry->slot, scratch);
+  writeback_cnt++;
+  entry_free(entry);
+}
+
+/* Sets up the pool. WRITEBACK writes an entry back to its slot on disk. */
+void zswap_init(zswap_writeback_func *writeback) {
+  if (!hash_init(&entries, entry_hash, entry_less, NULL)) PANIC("zswap_init: out of memory");
+  list_init(&lru);
+  lock_init(&zswap_lock);
+  writeback_page = writeback;
+
+  // 예산이 0이면 풀을 쓰지 않음
+  if (zswap_budget > 0 && (scratch = palloc_get_page(0)) == NULL) zswap_budget = 0;
+}
+
+/* Tries to keep the page at KVA, which is being swapped out to SLOT, in the
+ * compressed pool. Returns false if the page has to go to disk instead. */
+bool zswap_store(size_t slot, const void *kva) {
+  struct zswap_entry *entry = NULL;
+  size_t len, size;
+
+  if (zswap_budget == 0) return false;
+
+  lock_acquire(&zswap_lock);
+  ASSERT(entry_find(slot) == NULL);
+  len = lz_compress(kva, zbuf, sizeof zbuf);
+  size = entry_size(len);
+  if (len != 0 && size <= zswap_budget * PGSIZE) {
+    while (pool_bytes + size > zswap_budget * PGSIZE) writeback_lru();
+    entry = malloc(size);
+  }
+  if (entry == NULL) {
+    rejected_cnt++;
+    lock_release(&zswap_lock);
+    return false;
+  }
+
+  entry->slot = slot;
+  entry->len = len;
+  memcpy(entry->data, zbuf, len);
+  hash_insert(&entries, &entry->hash_elem);
+  list_push_back(&lru, &entry->lru_elem);
+  pool_bytes += size;
+
+  stored_cnt++;
+  orig_bytes += PGSIZE;
+  comp_bytes += len;
+  lock_release(&zswap_lock);
+  return true;
+}
+
+/* Fills the page at KVA with the contents of SLOT if they are in the pool.
+ * Returns false if they have to be read from disk. The entry stays in the
+ * pool until the slot is released, as other pages may share it. */
+bool zswap_load(size_t slot, void *kva) {
+  struct zswap_entry *entry;
+
+  lock_acquire(&zswap_lock);
+  entry = entry_find(slot);
+  if (entry != NULL) {
+    entry_read(entry, kva);
+    list_remove(&entry->lru_elem);
+    list_push_back(&lru, &entry->lru_elem);
+    hit_cnt++;
+  } else {
+    miss_cnt++;
+  }
+  lock_release(&zswap_lock);
+  return entry != NULL;
+}
+
+/* Forgets the contents of SLOT, which is being released. */
+void zswap_invalidate(size_t slot) {
+  struct zswap_entry *entry;
+
+  if (zswap_budget == 0) return;
+
+  lock_acquire(&zswap_lock);
+  entry = entry_find(slot);
+  if (entry != NULL) entry_free(entry);
+  lock_release(&zswap_lock);
+}
+
+/* Prints zswap statistics. */
+void zswap_print_stats(void) {
+  printf("Zswap: %lld stored, %lld rejected, %lld written back, %lld hits, %lld misses\n",
+         stored_cnt, rejected_cnt, writeback_cnt, hit_cnt, miss_cnt);
+  if (orig_bytes > 0)
+    printf("Zswap: %lld%% average compressed size\n", comp_bytes * 100 / orig_bytes);
+}